@@ -0,0 +1,350 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "NoiseTextureBaker.h"
+#include "VCETBakeEngine.h"
+#include "VCETBakeOutput.h"
+#include "VCETBakeMemory.h"
+#include "VCETBakeStats.h"
+#include "VCETModule.h"
+#include "VCETProceduralNoiseKernel.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeExit.h"
+#include "EngineUtils.h"
+
+UNoiseTextureBaker::UNoiseTextureBaker()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UNoiseTextureBaker::BeginPlay()
+{
+    Super::BeginPlay();
+    if (bBakeOnBeginPlay)
+    {
+        ForceRebake();
+    }
+}
+
+void UNoiseTextureBaker::RequestGlobalRebake(UObject* WorldContextObject)
+{
+    if (!WorldContextObject) return;
+    UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+    if (!World) return;
+
+    for (TActorIterator<AActor> It(World); It; ++It)
+    {
+        TArray<UNoiseTextureBaker*> Bakers;
+        (*It)->GetComponents<UNoiseTextureBaker>(Bakers);
+        for (auto* Baker : Bakers)
+        {
+            if (Baker && !Baker->IsBaking())
+            {
+                Baker->ForceRebake();
+            }
+        }
+    }
+}
+
+void UNoiseTextureBaker::ForceRebake()
+{
+    if (bIsBaking) return;
+    CreateRT();
+    BakeNoise();
+}
+
+void UNoiseTextureBaker::CreateRT()
+{
+    LLM_SCOPE_BYTAG(VCET_RenderTargets);
+
+    if (Mode == ENoiseTextureBakeMode::Texture2D)
+    {
+        if (RenderTarget) { Texture = RenderTarget; return; }
+
+        if (!Texture ||
+            Texture->SizeX != TextureWidth ||
+            Texture->SizeY != TextureHeight)
+        {
+            Texture = NewObject<UTextureRenderTarget2D>(this);
+            Texture->RenderTargetFormat = bUseHDR ? RTF_RGBA16f : RTF_RGBA8;
+            Texture->InitAutoFormat(TextureWidth, TextureHeight);
+            Texture->UpdateResourceImmediate(true);
+        }
+    }
+    else
+    {
+        if (VolumeRenderTarget) { VolumeTexture = VolumeRenderTarget; return; }
+
+        // UE5's UTextureRenderTargetVolume always creates PF_FloatRGBA, see UVolumeTextureBaker::CreateVolumeRT
+        const int32 Size = VolumeResolution;
+        if (!VolumeTexture ||
+            VolumeTexture->SizeX != Size ||
+            VolumeTexture->SizeY != Size)
+        {
+            VolumeTexture = NewObject<UTextureRenderTargetVolume>(this);
+            VolumeTexture->Init(Size, Size, Size, PF_FloatRGBA);
+            VolumeTexture->UpdateResourceImmediate(true);
+        }
+    }
+}
+
+namespace VCETNoiseTextureBaker
+{
+    struct FNoiseSettings
+    {
+        float FeatureScale = 1.f;
+        float Lacunarity = 2.f;
+        float Gain = 0.5f;
+        float VoronoiSmoothness = 1.f;
+        float WaveletPhase = 0.f;
+        float ScratchSmoothness = 0.05f;
+        int32 Seed = 0;
+        bool bFastMath = false;
+        ispc::EProceduralAccumulation Accumulation = ispc::ProceduralAccumulation_FBM;
+        // ISPC noise type and strength of each octave
+        TArray<int32> OctaveTypes;
+        TArray<float> OctaveStrengths;
+    };
+
+    // Evaluates the noise at the texel centers of a Size.X * Size.Y * Size.Z grid covering [Min, Min + Extent]
+    // Each row of texels shares its Y and Z, so a row is a single kernel call with constant Y/Z streams
+    // OutValues must already hold the whole grid
+    template<int32 Dimension>
+    void EvaluateGrid(const FNoiseSettings& Settings, const FVector& Min, const FVector& Extent, const FIntVector& Size, TArray<float>& OutValues)
+    {
+        VOXEL_SCOPE_COUNTER_FORMAT("Evaluate noise grid %dx%dx%d", Size.X, Size.Y, Size.Z);
+
+        using FArgs = TVCETProceduralNoiseArgs<Dimension>;
+
+        TVoxelArray<typename FArgs::FOctave> Octaves;
+        for (int32 Index = 0; Index < Settings.OctaveTypes.Num(); Index++)
+        {
+            typename FArgs::FOctave& Octave = Octaves.Emplace_GetRef();
+            FMemory::Memzero(Octave);
+            Octave.Type = decltype(Octave.Type)(Settings.OctaveTypes[Index]);
+            Octave.bStrengthIsConstant = true;
+            Octave.StrengthConstant = Settings.OctaveStrengths[Index];
+        }
+
+        // Processing happens after the bake: evaluate normalized noise
+        const float One = 1.f;
+
+        FArgs BaseArgs;
+        BaseArgs.Amplitude = FVCETNoiseStream(&One, true);
+        BaseArgs.FeatureScale = FVCETNoiseStream(&Settings.FeatureScale, true);
+        BaseArgs.Lacunarity = FVCETNoiseStream(&Settings.Lacunarity, true);
+        BaseArgs.Gain = FVCETNoiseStream(&Settings.Gain, true);
+        BaseArgs.VoronoiSmoothness = FVCETNoiseStream(&Settings.VoronoiSmoothness, true);
+        BaseArgs.WaveletPhase = FVCETNoiseStream(&Settings.WaveletPhase, true);
+        BaseArgs.ScratchSmoothness = FVCETNoiseStream(&Settings.ScratchSmoothness, true);
+        BaseArgs.Octaves = Octaves;
+        BaseArgs.Accumulation = Settings.Accumulation;
+        BaseArgs.Seed = Settings.Seed;
+        BaseArgs.bFastMath = Settings.bFastMath;
+
+        TArray<float> CoordinatesX;
+        CoordinatesX.SetNumUninitialized(Size.X);
+        for (int32 X = 0; X < Size.X; X++)
+        {
+            CoordinatesX[X] = float(Min.X + (double(X) + 0.5) / Size.X * Extent.X);
+        }
+
+        const int32 NumRows = Size.Y * Size.Z;
+        check(OutValues.Num() == NumRows * Size.X);
+
+        ParallelFor(NumRows, [&](const int32 RowIndex)
+        {
+            const int32 Y = RowIndex % Size.Y;
+            const int32 Z = RowIndex / Size.Y;
+
+            const float PositionY = float(Min.Y + (double(Y) + 0.5) / Size.Y * Extent.Y);
+            const float PositionZ = float(Min.Z + (double(Z) + 0.5) / Size.Z * Extent.Z);
+
+            FArgs Args = BaseArgs;
+            Args.Position[0] = FVCETNoiseStream(CoordinatesX.GetData(), false);
+            Args.Position[1] = FVCETNoiseStream(&PositionY, true);
+            if constexpr (Dimension == 3)
+            {
+                Args.Position[2] = FVCETNoiseStream(&PositionZ, true);
+            }
+
+            VCET::EvaluateProceduralNoise(Args, OutValues.GetData() + int64(RowIndex) * Size.X, 0, Size.X);
+        });
+    }
+}
+
+void UNoiseTextureBaker::BakeNoise()
+{
+    using namespace VCETNoiseTextureBaker;
+
+    const bool bVolume = Mode == ENoiseTextureBakeMode::Volume;
+    if (bVolume ? !VolumeTexture : !Texture)
+    {
+        return;
+    }
+
+    // The render target dictates the size, VolumeResolution or TextureWidth/Height unless an external one is set
+    FIntVector Size;
+    if (bVolume)
+    {
+        Size = FIntVector(VolumeTexture->SizeX, VolumeTexture->SizeY, VolumeTexture->SizeZ);
+        if (Size.X != Size.Y || Size.X != Size.Z)
+        {
+            UE_LOG(LogVCET, Error, TEXT("NoiseTextureBaker: Volume render target %s is %dx%dx%d, only cubic volumes are supported"),
+                *VolumeTexture->GetName(), Size.X, Size.Y, Size.Z);
+            return;
+        }
+    }
+    else
+    {
+        Size = FIntVector(Texture->SizeX, Texture->SizeY, 1);
+    }
+
+    bIsBaking = true;
+
+    FNoiseSettings Settings;
+    Settings.FeatureScale = FMath::Max(FeatureScale, 0.001f);
+    Settings.Lacunarity = Lacunarity;
+    Settings.Gain = Gain;
+    Settings.VoronoiSmoothness = VoronoiSmoothness;
+    Settings.WaveletPhase = WaveletPhase;
+    Settings.ScratchSmoothness = ScratchSmoothness;
+    Settings.Seed = Seed;
+    Settings.bFastMath = bFastMath;
+    Settings.Accumulation = GetISPCAccumulation(Accumulation);
+
+    const int32 Octaves = FMath::Clamp(NumOctaves, 1, 255);
+    for (int32 Index = 0; Index < Octaves; Index++)
+    {
+        Settings.OctaveTypes.Add(bVolume ? int32(GetISPCNoise(NoiseType3D)) : int32(GetISPCNoise(NoiseType2D)));
+        Settings.OctaveStrengths.Add(OctaveStrengths.IsValidIndex(Index) ? OctaveStrengths[Index] : 1.f);
+    }
+
+    // Processed by the bake engine as a distance field: remap, multiply, invert, then normalize or clamp
+    VCET::FBakeProcessing Processing;
+    Processing.bRemap = bRemapNegativeToPositive;
+    Processing.bNormalize = bAutoNormalize;
+    Processing.bInvert = bInvertResult;
+    Processing.Multiplier = ResultMultiplier;
+
+    FVector Extent = RegionSize;
+    if (!bVolume)
+    {
+        Extent.Z = 0.;
+    }
+    const FVector Min = RegionCenter - Extent * 0.5;
+
+    TWeakObjectPtr<UNoiseTextureBaker> WeakThis(this);
+
+    const int64 Bytes = VCET::EstimateBakeBytes(Size.X * Size.Y * Size.Z);
+
+    // Before the budget, so that QueueWaitMs includes the wait for memory
+    const double LaunchTime = FPlatformTime::Seconds();
+
+    VCET::FBakeMemoryBudget::Get().LaunchBake(this, Bytes, [=]
+    {
+        VCET::BeginBakeInFlight();
+
+        Voxel::AsyncTask([Settings, Processing, Min, Extent, Size, bVolume, LaunchTime]() -> TVoxelFuture<VCET::FBakeResult>
+        {
+            VOXEL_FUNCTION_COUNTER();
+
+            const double StartTime = FPlatformTime::Seconds();
+            const int32 Num = Size.X * Size.Y * Size.Z;
+
+            // No voxel source: the noise kernels are this baker's query, and their values are processed as a distance field
+            const VCET::FBakeSource Source;
+
+            VCET::FBakeData Data;
+            VCET::BeginBake(Source, Processing, Num, Data);
+            {
+                // Wall time: the rows are evaluated in parallel
+                VCET_BAKE_TIMED_SCOPE(Query, Data);
+                LLM_SCOPE_BYTAG(VCET_Results);
+
+                if (bVolume)
+                {
+                    EvaluateGrid<3>(Settings, Min, Extent, Size, Data.Values);
+                }
+                else
+                {
+                    EvaluateGrid<2>(Settings, Min, Extent, Size, Data.Values);
+                }
+            }
+            VCET::AddBakeSamples(Num);
+
+            VCET::FBakeResult Result = VCET::FinishBake(Source, Processing, Data);
+            VCET::FillBakeTelemetry(Data, 0, Num, LaunchTime, StartTime, Result);
+
+            VCET::EndBakeInFlight();
+            return Result;
+
+        }).Then_GameThread([WeakThis, Size, bVolume, Bytes](const VCET::FBakeResult& Result)
+        {
+            VCET_BAKE_SCOPE(GameThread);
+
+            ON_SCOPE_EXIT
+            {
+                VCET::FBakeMemoryBudget::Get().ReleaseBake(Bytes);
+            };
+
+            UNoiseTextureBaker* This = WeakThis.Get();
+            if (!This) return;
+
+            This->CachedMode = bVolume ? ENoiseTextureBakeMode::Volume : ENoiseTextureBakeMode::Texture2D;
+            This->SetCachedColors(TEXT("Noise"), Result.Colors, Size);
+
+            FVCETBakeTelemetry Telemetry = Result.Telemetry;
+            if (bVolume)
+            {
+                VCET::WriteColorToVolumeRenderTarget(This->VolumeTexture, Result.Colors, Size.X, &Telemetry);
+            }
+            else
+            {
+                VCET::WriteColorToRenderTarget(This->Texture, Result.Colors, Size.X, Size.Y, &Telemetry);
+            }
+
+            if (This->bCreateStaticAsset)
+            {
+                This->StaticTexture = This->CreateStaticTexture();
+            }
+
+            This->RecordBakeTelemetry(Telemetry, bVolume ? TEXT("Volume") : TEXT("Texture2D"));
+
+            This->bIsBaking = false;
+            This->OnBakeComplete.Broadcast();
+        });
+    });
+}
+
+UTexture* UNoiseTextureBaker::CreateStaticTexture()
+{
+    return CreateStaticTextureImpl(false);
+}
+
+TArray<UTexture*> UNoiseTextureBaker::SaveBakedTextures(bool bReplaceExisting)
+{
+    TArray<UTexture*> Textures;
+    if (UTexture* Texture = CreateStaticTextureImpl(bReplaceExisting))
+    {
+        Textures.Add(Texture);
+    }
+    return Textures;
+}
+
+UTexture* UNoiseTextureBaker::CreateStaticTextureImpl(bool bReplaceExisting)
+{
+    const FVCETBakeCache* Cache = FindCachedColors(TEXT("Noise"));
+    if (!Cache)
+    {
+        UE_LOG(LogVCET, Error, TEXT("NoiseTextureBaker: Cannot create static texture - no cached data available. Run ForceRebake() first."));
+        return nullptr;
+    }
+
+    const FString PackagePath = AssetOutputPath.IsEmpty() ? TEXT("/Game/VCET/Noise") : AssetOutputPath;
+
+    if (CachedMode == ENoiseTextureBakeMode::Volume)
+    {
+        return VCET::CreateStaticVolumeTexture(Cache->Colors, Cache->Size.X, PackagePath, AssetBaseName, bReplaceExisting);
+    }
+    return VCET::CreateStaticTexture2D(Cache->Colors, Cache->Size.X, Cache->Size.Y, PackagePath, AssetBaseName, bReplaceExisting);
+}
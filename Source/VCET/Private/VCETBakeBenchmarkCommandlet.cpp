@@ -0,0 +1,499 @@
+// Copyright Zundle. MIT License.
+
+#include "VCETBakeBenchmarkCommandlet.h"
+#include "VCETBakeEngine.h"
+#include "VCETBakeOutput.h"
+#include "VCETSyntheticLayer.h"
+#include "VCETModule.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTargetVolume.h"
+#include "RenderingThread.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+
+namespace VCETBakeBenchmark
+{
+    TArray<int32> ParseIntList(const FString& Params, const TCHAR* Key, const TArray<int32>& Default)
+    {
+        FString Value;
+        if (!FParse::Value(*Params, Key, Value, false))
+        {
+            return Default;
+        }
+
+        TArray<FString> Parts;
+        Value.ParseIntoArray(Parts, TEXT(","));
+
+        TArray<int32> Result;
+        for (const FString& Part : Parts)
+        {
+            const int32 Int = FCString::Atoi(*Part);
+            if (Int > 0)
+            {
+                Result.Add(Int);
+            }
+        }
+        return Result.Num() > 0 ? Result : Default;
+    }
+
+    const TCHAR* GetMetadataName(const VCET::EBakeMetadataType Type)
+    {
+        switch (Type)
+        {
+        case VCET::EBakeMetadataType::Float: return TEXT("Float");
+        case VCET::EBakeMetadataType::LinearColor: return TEXT("Color");
+        case VCET::EBakeMetadataType::Normal: return TEXT("Normal");
+        case VCET::EBakeMetadataType::Packed: return TEXT("Packed");
+        default: return TEXT("Distance");
+        }
+    }
+
+    const TCHAR* GetSampleOrderName(const VCET::EBakeSampleOrder Order)
+    {
+        switch (Order)
+        {
+        case VCET::EBakeSampleOrder::Bricks: return TEXT("Bricks");
+        case VCET::EBakeSampleOrder::Morton: return TEXT("Morton");
+        default: return TEXT("Linear");
+        }
+    }
+
+    // RunBakeJobs() reads the sample order from vcet.Bake.SampleOrder
+    void SetSampleOrder(const VCET::EBakeSampleOrder Order)
+    {
+        if (IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(TEXT("vcet.Bake.SampleOrder")))
+        {
+            CVar->Set(int32(Order), ECVF_SetByCode);
+        }
+    }
+
+    struct FRow
+    {
+        FString Baker;
+        FString Metadata;
+        VCET::EBakeSampleOrder Order = VCET::EBakeSampleOrder::Linear;
+        FIntVector Size = FIntVector::ZeroValue;
+        // Bakes run together by one RunBakeJobs() call, as coalesced bakes are
+        int32 NumBakes = 1;
+        int32 NumSamples = 0;
+
+        // Wall time of RunBakeJobs()
+        double BakeSeconds = 0.;
+        double ConversionSeconds = 0.;
+        double UploadSeconds = 0.;
+
+        // Worker phases from the bake telemetry: cycles summed over the chunks run in parallel, not wall time
+        double PositionsCpuMs = 0.;
+        double QueryCpuMs = 0.;
+        double ProcessingCpuMs = 0.;
+
+        // Peak memory of the bakes from their telemetry, plus their converted pixels
+        int64 PeakBakeBytes = 0;
+
+        // Linear keeps the keys of the baselines recorded before the sample orders, a single bake those recorded before coalescing
+        FString GetKey() const
+        {
+            FString Key = FString::Printf(TEXT("%s_%s_%dx%dx%d"), *Baker, *Metadata, Size.X, Size.Y, Size.Z);
+            if (Order != VCET::EBakeSampleOrder::Linear)
+            {
+                Key += TEXT("_") + FString(GetSampleOrderName(Order));
+            }
+            if (NumBakes > 1)
+            {
+                Key += FString::Printf(TEXT("_x%d"), NumBakes);
+            }
+            return Key;
+        }
+        double GetTotalSeconds() const
+        {
+            return BakeSeconds + ConversionSeconds + UploadSeconds;
+        }
+        double GetSamplesPerSecond() const
+        {
+            return NumSamples / GetTotalSeconds();
+        }
+    };
+
+    // Runs NumBakes bakes of Mapping through VCET::RunBakeJobs(), the code path of the bakers (chunking, sample order,
+    // shared query batches), then converts and uploads each result as the game thread would
+    template<typename MappingType>
+    FRow RunOnce(const TCHAR* Baker, const FIntVector& Size, const MappingType& Mapping, const VCET::FBakeSource& Source, const VCET::FBakeProcessing& Processing, const VCET::EBakeSampleOrder Order, const int32 NumBakes)
+    {
+        FRow Row;
+        Row.Baker = Baker;
+        Row.Metadata = GetMetadataName(Source.MetadataType);
+        Row.Order = Order;
+        Row.Size = Size;
+        Row.NumBakes = NumBakes;
+        Row.NumSamples = Mapping.Num() * NumBakes;
+
+        TArray<TSharedRef<VCET::FBakeJob>> Jobs;
+        for (int32 Index = 0; Index < NumBakes; Index++)
+        {
+            Jobs.Add(VCET::MakeBakeJob(Mapping, Processing));
+        }
+
+        SetSampleOrder(Order);
+
+        double StartTime = FPlatformTime::Seconds();
+        const TArray<VCET::FBakeResult> Results = VCET::RunBakeJobs(Source, Jobs);
+        Row.BakeSeconds = FPlatformTime::Seconds() - StartTime;
+
+        Jobs.Empty();
+
+        UTextureRenderTargetVolume* VolumeRT = nullptr;
+        UTextureRenderTarget2D* RT = nullptr;
+        if (FApp::CanEverRender())
+        {
+            if (Size.Z > 1)
+            {
+                VolumeRT = NewObject<UTextureRenderTargetVolume>();
+                VolumeRT->Init(Size.X, Size.Y, Size.Z, PF_FloatRGBA);
+                VolumeRT->UpdateResourceImmediate(true);
+            }
+            else
+            {
+                RT = NewObject<UTextureRenderTarget2D>();
+                RT->RenderTargetFormat = RTF_RGBA16f;
+                RT->InitAutoFormat(Size.X, Size.Y);
+                RT->UpdateResourceImmediate(true);
+            }
+            FlushRenderingCommands();
+        }
+
+        for (const VCET::FBakeResult& Result : Results)
+        {
+            Row.PositionsCpuMs += Result.Telemetry.PositionsMs;
+            Row.QueryCpuMs += Result.Telemetry.QueryMs + Result.Telemetry.MetadataCopyMs;
+            Row.ProcessingCpuMs += Result.Telemetry.PostProcessMs;
+
+            StartTime = FPlatformTime::Seconds();
+            TSharedRef<TArray<uint8>> Pixels = MakeShared<TArray<uint8>>();
+            const int32 BytesPerPixel = VCET::ConvertColorsToPixelFormat(Result.Colors, PF_FloatRGBA, *Pixels);
+            Row.ConversionSeconds += FPlatformTime::Seconds() - StartTime;
+
+            Row.PeakBakeBytes += Result.Telemetry.PeakMemoryBytes + Pixels->GetAllocatedSize();
+
+            StartTime = FPlatformTime::Seconds();
+            if (VolumeRT)
+            {
+                VCET::UploadToVolumeRenderTarget(VolumeRT, Pixels, BytesPerPixel, Size.X);
+                FlushRenderingCommands();
+            }
+            else if (RT)
+            {
+                VCET::UploadToRenderTarget(RT, Pixels, BytesPerPixel, Size.X, Size.Y);
+                FlushRenderingCommands();
+            }
+            Row.UploadSeconds += FPlatformTime::Seconds() - StartTime;
+        }
+
+        return Row;
+    }
+
+    // Warms up, then keeps the fastest of Iterations runs
+    template<typename MappingType>
+    FRow Run(const TCHAR* Baker, const FIntVector& Size, const MappingType& Mapping, const VCET::FBakeSource& Source, const VCET::FBakeProcessing& Processing, const VCET::EBakeSampleOrder Order, const int32 NumBakes, const int32 Iterations)
+    {
+        RunOnce(Baker, Size, Mapping, Source, Processing, Order, NumBakes);
+
+        FRow Best;
+        for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+        {
+            const FRow Row = RunOnce(Baker, Size, Mapping, Source, Processing, Order, NumBakes);
+            if (Iteration == 0 || Row.GetTotalSeconds() < Best.GetTotalSeconds())
+            {
+                Best = Row;
+            }
+        }
+
+        UE_LOG(LogVCET, Display, TEXT("VCETBakeBenchmark: %-36s %10d samples  bake %7.2fms (cpu: positions %7.2fms  query %7.2fms  processing %7.2fms)  conversion %7.2fms  upload %7.2fms  %12.0f samples/s"),
+            *Best.GetKey(), Best.NumSamples,
+            Best.BakeSeconds * 1000., Best.PositionsCpuMs, Best.QueryCpuMs, Best.ProcessingCpuMs,
+            Best.ConversionSeconds * 1000., Best.UploadSeconds * 1000., Best.GetSamplesPerSecond());
+
+        return Best;
+    }
+
+    // Key -> samples/sec of a previous run
+    TMap<FString, double> LoadBaseline(const FString& Path)
+    {
+        TMap<FString, double> Baseline;
+
+        TArray<FString> Lines;
+        if (!FFileHelper::LoadFileToStringArray(Lines, *Path) || Lines.Num() == 0)
+        {
+            return Baseline;
+        }
+
+        TArray<FString> Header;
+        Lines[0].ParseIntoArray(Header, TEXT(","));
+        const int32 KeyColumn = Header.IndexOfByKey(TEXT("Key"));
+        const int32 ThroughputColumn = Header.IndexOfByKey(TEXT("SamplesPerSecond"));
+        if (KeyColumn == INDEX_NONE || ThroughputColumn == INDEX_NONE)
+        {
+            return Baseline;
+        }
+
+        for (int32 LineIndex = 1; LineIndex < Lines.Num(); LineIndex++)
+        {
+            TArray<FString> Columns;
+            Lines[LineIndex].ParseIntoArray(Columns, TEXT(","));
+            if (Columns.IsValidIndex(KeyColumn) && Columns.IsValidIndex(ThroughputColumn))
+            {
+                Baseline.Add(Columns[KeyColumn], FCString::Atod(*Columns[ThroughputColumn]));
+            }
+        }
+        return Baseline;
+    }
+}
+
+UVCETBakeBenchmarkCommandlet::UVCETBakeBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UVCETBakeBenchmarkCommandlet::Main(const FString& Params)
+{
+    using namespace VCETBakeBenchmark;
+
+    const TArray<int32> Sizes = ParseIntList(Params, TEXT("Sizes="), { 256, 512, 1024 });
+    const TArray<int32> VolumeSizes = ParseIntList(Params, TEXT("VolumeSizes="), { 32, 64, 128 });
+
+    TArray<FString> Bakers = { TEXT("Planar"), TEXT("Equirect"), TEXT("Cube"), TEXT("Volume"), TEXT("Shell") };
+    FString BakerList;
+    if (FParse::Value(*Params, TEXT("Bakers="), BakerList, false))
+    {
+        BakerList.ParseIntoArray(Bakers, TEXT(","));
+    }
+    const auto IsBakerEnabled = [&](const TCHAR* Name)
+    {
+        return Bakers.ContainsByPredicate([&](const FString& Baker) { return Baker.Equals(Name, ESearchCase::IgnoreCase); });
+    };
+
+    int32 Iterations = 3;
+    FParse::Value(*Params, TEXT("Iterations="), Iterations);
+    Iterations = FMath::Max(Iterations, 1);
+
+    int32 NumBakes = 1;
+    FParse::Value(*Params, TEXT("Coalesce="), NumBakes);
+    NumBakes = FMath::Max(NumBakes, 1);
+
+    double Threshold = 0.1;
+    FParse::Value(*Params, TEXT("Threshold="), Threshold);
+
+    FString OutputPath;
+    if (!FParse::Value(*Params, TEXT("Output="), OutputPath))
+    {
+        OutputPath = FPaths::ProjectSavedDir() / TEXT("VCET") / TEXT("Benchmarks") /
+            FString::Printf(TEXT("BakeBenchmark-%s.csv"), *FDateTime::Now().ToString());
+    }
+
+    VCET::EBakeMetadataType MetadataType = VCET::EBakeMetadataType::None;
+    FString MetadataName;
+    if (FParse::Value(*Params, TEXT("Metadata="), MetadataName))
+    {
+        for (const VCET::EBakeMetadataType Type : { VCET::EBakeMetadataType::Float, VCET::EBakeMetadataType::LinearColor, VCET::EBakeMetadataType::Normal, VCET::EBakeMetadataType::Packed })
+        {
+            if (MetadataName.Equals(GetMetadataName(Type), ESearchCase::IgnoreCase))
+            {
+                MetadataType = Type;
+            }
+        }
+    }
+
+    // Every case runs once per order, to compare their query throughput. Linear by default, whatever vcet.Bake.SampleOrder is,
+    // so the keys stay unsuffixed and match baselines written before sample orders existed
+    TArray<VCET::EBakeSampleOrder> Orders = { VCET::EBakeSampleOrder::Linear };
+    FString OrderList;
+    if (FParse::Value(*Params, TEXT("SampleOrders="), OrderList, false))
+    {
+        TArray<FString> OrderNames;
+        OrderList.ParseIntoArray(OrderNames, TEXT(","));
+
+        Orders.Reset();
+        for (const VCET::EBakeSampleOrder Order : { VCET::EBakeSampleOrder::Linear, VCET::EBakeSampleOrder::Bricks, VCET::EBakeSampleOrder::Morton })
+        {
+            if (OrderNames.ContainsByPredicate([&](const FString& Name) { return Name.Equals(GetSampleOrderName(Order), ESearchCase::IgnoreCase); }))
+            {
+                Orders.Add(Order);
+            }
+        }
+        if (Orders.Num() == 0)
+        {
+            UE_LOG(LogVCET, Warning, TEXT("VCETBakeBenchmark: No sample order in -SampleOrders=%s, running Linear"), *OrderList);
+            Orders.Add(VCET::EBakeSampleOrder::Linear);
+        }
+    }
+
+    UE_LOG(LogVCET, Display, TEXT("VCETBakeBenchmark: %s, chunk size %d, brick size %d, %d bakes per run, %d iterations per case%s"),
+        GetMetadataName(MetadataType), VCET::GetBakeChunkSize(), VCET::GetBakeBrickSize(), NumBakes, Iterations,
+        FApp::CanEverRender() ? TEXT("") : TEXT(", upload skipped (no RHI)"));
+
+    // Every case samples the same analytic layer, shaped to cross the surfaces of the default mappings below
+    VCET::FBakeSource Source;
+    Source.InitializeSynthetic(MakeShared<VCET::FSyntheticLayer>(), MetadataType);
+
+    if (MetadataType == VCET::EBakeMetadataType::Packed)
+    {
+        // Distance, float, color and normal in one pass, as a baker packing four sources would
+        const VCET::EBakeChannelType ChannelTypes[] = { VCET::EBakeChannelType::Distance, VCET::EBakeChannelType::Float, VCET::EBakeChannelType::LinearColor, VCET::EBakeChannelType::Normal };
+        for (int32 Index = 0; Index < 4; Index++)
+        {
+            VCET::FBakeChannel& Channel = Source.Channels.AddDefaulted_GetRef();
+            Channel.Type = ChannelTypes[Index];
+            Channel.Component = Index;
+            Channel.bClamp = true;
+        }
+    }
+
+    // Processing of the bakers using each mapping
+    VCET::FBakeProcessing SurfaceProcessing;
+    VCET::FBakeProcessing VolumeProcessing;
+    VolumeProcessing.FloatMetadataMode = VCET::EBakeFloatMetadataMode::Grayscale;
+    VolumeProcessing.bProcessColors = true;
+
+    // Each run sets vcet.Bake.SampleOrder, restored once done
+    const VCET::EBakeSampleOrder InitialOrder = VCET::GetBakeSampleOrder();
+
+    TArray<FRow> Rows;
+    for (const VCET::EBakeSampleOrder Order : Orders)
+    {
+        for (const int32 Size : Sizes)
+        {
+            if (IsBakerEnabled(TEXT("Planar")))
+            {
+                VCET::FPlanarBakeMapping Mapping;
+                Mapping.Min = FVector2D(-50000.);
+                Mapping.Max = FVector2D(50000.);
+                Mapping.Z = 600000.;
+                Mapping.Width = Size;
+                Mapping.Height = Size;
+                Rows.Add(Run(TEXT("Planar"), FIntVector(Size, Size, 1), Mapping, Source, SurfaceProcessing, Order, NumBakes, Iterations));
+            }
+            if (IsBakerEnabled(TEXT("Equirect")))
+            {
+                VCET::FEquirectBakeMapping Mapping;
+                Mapping.Radius = 610000.;
+                Mapping.Width = Size;
+                Mapping.Height = Size / 2;
+                Rows.Add(Run(TEXT("Equirect"), FIntVector(Size, Size / 2, 1), Mapping, Source, SurfaceProcessing, Order, NumBakes, Iterations));
+            }
+            if (IsBakerEnabled(TEXT("Cube")))
+            {
+                VCET::FCubeBakeMapping Mapping;
+                Mapping.Radius = 610000.;
+                Mapping.FaceSize = Size / 2;
+                Rows.Add(Run(TEXT("Cube"), FIntVector(6 * (Size / 2), Size / 2, 1), Mapping, Source, SurfaceProcessing, Order, NumBakes, Iterations));
+            }
+        }
+        for (const int32 Size : VolumeSizes)
+        {
+            if (IsBakerEnabled(TEXT("Volume")))
+            {
+                VCET::FVolumeBakeMapping Mapping;
+                Mapping.Min = FVector(-50000., -50000., 570000.);
+                Mapping.Extent = FVector(100000.);
+                Mapping.Size = Size;
+                Rows.Add(Run(TEXT("Volume"), FIntVector(Size), Mapping, Source, VolumeProcessing, Order, NumBakes, Iterations));
+            }
+            if (IsBakerEnabled(TEXT("Shell")))
+            {
+                VCET::FShellBakeMapping Mapping;
+                Mapping.InnerRadius = 590000.;
+                Mapping.OuterRadius = 630000.;
+                Mapping.Size = Size;
+                Rows.Add(Run(TEXT("Shell"), FIntVector(Size), Mapping, Source, VolumeProcessing, Order, NumBakes, Iterations));
+            }
+        }
+    }
+
+    SetSampleOrder(InitialOrder);
+
+    FString Csv = TEXT("Key,Baker,Metadata,SampleOrder,SizeX,SizeY,SizeZ,NumBakes,NumSamples,ChunkSize,BakeMs,PositionsCpuMs,QueryCpuMs,ProcessingCpuMs,ConversionMs,UploadMs,TotalMs,SamplesPerSecond,PeakBakeMB\n");
+    for (const FRow& Row : Rows)
+    {
+        Csv += FString::Printf(TEXT("%s,%s,%s,%s,%d,%d,%d,%d,%d,%d,%f,%f,%f,%f,%f,%f,%f,%f,%f\n"),
+            *Row.GetKey(),
+            *Row.Baker,
+            *Row.Metadata,
+            GetSampleOrderName(Row.Order),
+            Row.Size.X,
+            Row.Size.Y,
+            Row.Size.Z,
+            Row.NumBakes,
+            Row.NumSamples,
+            VCET::GetBakeChunkSize(),
+            Row.BakeSeconds * 1000.,
+            Row.PositionsCpuMs,
+            Row.QueryCpuMs,
+            Row.ProcessingCpuMs,
+            Row.ConversionSeconds * 1000.,
+            Row.UploadSeconds * 1000.,
+            Row.GetTotalSeconds() * 1000.,
+            Row.GetSamplesPerSecond(),
+            Row.PeakBakeBytes / double(1 << 20));
+    }
+
+    if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCETBakeBenchmark: Failed to write %s"), *OutputPath);
+        return 1;
+    }
+
+    UE_LOG(LogVCET, Display, TEXT("VCETBakeBenchmark: Wrote %d results to %s"), Rows.Num(), *OutputPath);
+
+    FString BaselinePath;
+    if (!FParse::Value(*Params, TEXT("Baseline="), BaselinePath))
+    {
+        return 0;
+    }
+
+    const TMap<FString, double> Baseline = LoadBaseline(BaselinePath);
+    if (Baseline.Num() == 0)
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCETBakeBenchmark: Failed to read baseline %s"), *BaselinePath);
+        return 1;
+    }
+
+    int32 NumRegressions = 0;
+    int32 NumCompared = 0;
+    for (const FRow& Row : Rows)
+    {
+        const double* BaselineThroughput = Baseline.Find(Row.GetKey());
+        if (!BaselineThroughput || *BaselineThroughput <= 0.)
+        {
+            UE_LOG(LogVCET, Warning, TEXT("VCETBakeBenchmark: %s is not in the baseline, not compared"), *Row.GetKey());
+            continue;
+        }
+        NumCompared++;
+
+        const double Ratio = Row.GetSamplesPerSecond() / *BaselineThroughput;
+        if (Ratio < 1. - Threshold)
+        {
+            UE_LOG(LogVCET, Error, TEXT("VCETBakeBenchmark: %s regressed: %.0f samples/s vs %.0f in the baseline (%.1f%%)"),
+                *Row.GetKey(), Row.GetSamplesPerSecond(), *BaselineThroughput, (Ratio - 1.) * 100.);
+            NumRegressions++;
+        }
+        else
+        {
+            UE_LOG(LogVCET, Display, TEXT("VCETBakeBenchmark: %s: %+.1f%% vs baseline"), *Row.GetKey(), (Ratio - 1.) * 100.);
+        }
+    }
+
+    // A baseline matching none of the cases checks nothing: a different machine setup, sample order or set of cases
+    if (NumCompared == 0)
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCETBakeBenchmark: No case matches the baseline %s"), *BaselinePath);
+        return 1;
+    }
+
+    UE_LOG(LogVCET, Display, TEXT("VCETBakeBenchmark: %d of %d cases compared against the baseline, %d regressed"), NumCompared, Rows.Num(), NumRegressions);
+
+    return NumRegressions > 0 ? 1 : 0;
+}
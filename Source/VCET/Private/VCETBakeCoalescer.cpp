@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETBakeCoalescer.h"
+#include "VCETModule.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+
+int32 GVCETBakeCoalesce = 1;
+static FAutoConsoleVariableRef CVarVCETBakeCoalesce(
+    TEXT("vcet.Bake.Coalesce"),
+    GVCETBakeCoalesce,
+    TEXT("1: bakes requested during a frame that sample the same layer and metadata run together at the next tick, sharing their queries. 0: every bake runs on its own, right away."));
+
+void VCET::LaunchCoalescedBake(const FBakeSource& Source, const TSharedRef<FBakeJob>& Job, TFunction<void(const FBakeResult&)> OnBaked)
+{
+    FBakeCoalescer::Get().AddBake(Source, Job, MoveTemp(OnBaked));
+}
+
+VCET::FBakeCoalescer& VCET::FBakeCoalescer::Get()
+{
+    static FBakeCoalescer Coalescer;
+    return Coalescer;
+}
+
+bool VCET::FBakeCoalescer::IsEnabled()
+{
+    return GVCETBakeCoalesce != 0;
+}
+
+void VCET::FBakeCoalescer::AddBake(const FBakeSource& Source, const TSharedRef<FBakeJob>& Job, TFunction<void(const FBakeResult&)> OnBaked)
+{
+    check(IsInGameThread());
+
+    if (!IsEnabled())
+    {
+        Launch({ Source, { Job }, { MoveTemp(OnBaked) } });
+        return;
+    }
+
+    FGroup* Group = Groups.FindByPredicate([&](const FGroup& Other)
+    {
+        return
+            Other.Source.CanShareQueries(Source) &&
+            (Source.MetadataType != EBakeMetadataType::Float || Other.Jobs[0]->Processing.FloatMetadataMode == Job->Processing.FloatMetadataMode);
+    });
+    if (!Group)
+    {
+        Group = &Groups.AddDefaulted_GetRef();
+        Group->Source = Source;
+    }
+    Group->Jobs.Add(Job);
+    Group->Callbacks.Add(MoveTemp(OnBaked));
+
+    if (!bFlushScheduled)
+    {
+        bFlushScheduled = true;
+        FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this](float)
+        {
+            Flush();
+            return false;
+        }));
+    }
+}
+
+void VCET::FBakeCoalescer::Flush()
+{
+    check(IsInGameThread());
+
+    bFlushScheduled = false;
+
+    TArray<FGroup> GroupsToLaunch = MoveTemp(Groups);
+    for (FGroup& Group : GroupsToLaunch)
+    {
+        if (Group.Jobs.Num() > 1)
+        {
+            UE_LOG(LogVCET, Verbose, TEXT("VCET: Coalesced %d bakes sharing their queries"), Group.Jobs.Num());
+        }
+        Launch(MoveTemp(Group));
+    }
+}
+
+void VCET::FBakeCoalescer::Launch(FGroup Group)
+{
+    for (int32 Index = 0; Index < Group.Jobs.Num(); Index++)
+    {
+        BeginBakeInFlight();
+    }
+
+    Voxel::AsyncTask([SharedGroup = MakeShared<FGroup>(MoveTemp(Group))]
+    {
+        VOXEL_FUNCTION_COUNTER();
+
+        // Each bake completes as soon as its own chunks are done, not once the whole group is
+        RunBakeJobs(SharedGroup->Source, SharedGroup->Jobs, [&](const int32 JobIndex, FBakeResult&& Result)
+        {
+            EndBakeInFlight();
+
+            AsyncTask(ENamedThreads::GameThread, [SharedGroup, JobIndex, Result = MoveTemp(Result)]
+            {
+                SharedGroup->Callbacks[JobIndex](Result);
+            });
+        });
+    });
+}
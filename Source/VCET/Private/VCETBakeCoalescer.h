@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VCETBakeEngine.h"
+
+namespace VCET
+{
+    /**
+     * Coalesces the bakes requested during a frame (vcet.Bake.Coalesce).
+     *
+     * Bakes are grouped by what they query: same layers, metadata, channels and LOD (FBakeSource::CanShareQueries()), and
+     * for float metadata the same FBakeProcessing::FloatMetadataMode. At the next tick of the core ticker, each group runs
+     * as one RunBakeJobs() task, so that bakes fired together (RequestGlobalRebake(), level load, a bake commandlet) share
+     * their queries instead of each building its own. Each completion is called on the game thread as soon as its own bake
+     * is done, without waiting for the rest of its group.
+     *
+     * Game thread only.
+     */
+    class FBakeCoalescer
+    {
+    public:
+        static FBakeCoalescer& Get();
+
+        static bool IsEnabled();
+
+        void AddBake(const FBakeSource& Source, const TSharedRef<FBakeJob>& Job, TFunction<void(const FBakeResult&)> OnBaked);
+
+    private:
+        struct FGroup
+        {
+            FBakeSource Source;
+            TArray<TSharedRef<FBakeJob>> Jobs;
+            TArray<TFunction<void(const FBakeResult&)>> Callbacks;
+        };
+
+        TArray<FGroup> Groups;
+        bool bFlushScheduled = false;
+
+        /** Launches every group */
+        void Flush();
+        static void Launch(FGroup Group);
+    };
+}
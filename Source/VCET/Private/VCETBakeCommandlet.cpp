@@ -0,0 +1,348 @@
+// Copyright Zundle. MIT License.
+
+#include "VCETBakeCommandlet.h"
+#include "VCETBakerComponent.h"
+#include "VCETBakeTelemetry.h"
+#include "VCETModule.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Tickable.h"
+#include "Containers/Ticker.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace VCETBake
+{
+    enum class EStatus : uint8
+    {
+        Pending,
+        Running,
+        Succeeded,
+        Failed
+    };
+
+    struct FJob
+    {
+        FString Map;
+        FString Name;
+        FString Class;
+        TWeakObjectPtr<UVCETBakerComponent> Baker;
+
+        EStatus Status = EStatus::Pending;
+        double StartTime = 0.;
+        double Seconds = 0.;
+        int32 NumTextures = 0;
+        FString Error;
+
+        void Fail(const FString& InError)
+        {
+            Status = EStatus::Failed;
+            Error = InError;
+            UE_LOG(LogVCET, Error, TEXT("VCETBake: %s %s: %s"), *Map, *Name, *Error);
+        }
+    };
+
+    UWorld* LoadMap(const FString& Map)
+    {
+        UPackage* Package = LoadPackage(nullptr, *Map, LOAD_None);
+        UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+        if (!World)
+        {
+            return nullptr;
+        }
+
+        World->WorldType = EWorldType::Editor;
+        World->AddToRoot();
+
+        if (!World->bIsWorldInitialized)
+        {
+            World->InitWorld(UWorld::InitializationValues()
+                .AllowAudioPlayback(false)
+                .RequiresHitProxies(false)
+                .CreatePhysicsScene(false)
+                .CreateNavigation(false)
+                .CreateAISystem(false)
+                .ShouldSimulatePhysics(false)
+                .EnableTraceCollision(false)
+                .SetTransactional(false)
+                .CreateFXSystem(false));
+        }
+
+        FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+        WorldContext.SetCurrentWorld(World);
+
+        World->UpdateWorldComponents(true, true);
+        World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+        return World;
+    }
+
+    void UnloadMap(UWorld* World)
+    {
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+        World->RemoveFromRoot();
+        CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+    }
+
+    // There is no engine loop in a commandlet: run the game thread tasks the bakes continue on
+    void Tick(const float DeltaTime)
+    {
+        FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+        FTSTicker::GetCoreTicker().Tick(DeltaTime);
+        FTickableGameObject::TickObjects(nullptr, LEVELTICK_All, false, DeltaTime);
+    }
+
+    // Runs the jobs of one map, at most NumWorkers at once. Returns once they all succeeded or failed
+    // A job times out Timeout seconds after its bake started, so that jobs waiting for a worker aren't charged for the wait
+    void RunJobs(TArray<FJob>& Jobs, const int32 NumWorkers, const double Timeout, const bool bSave, const bool bOverwrite)
+    {
+        double LastTickTime = FPlatformTime::Seconds();
+
+        while (true)
+        {
+            int32 NumRunning = 0;
+            int32 NumPending = 0;
+            for (const FJob& Job : Jobs)
+            {
+                NumRunning += Job.Status == EStatus::Running;
+                NumPending += Job.Status == EStatus::Pending;
+            }
+
+            if (NumRunning == 0 && NumPending == 0)
+            {
+                return;
+            }
+
+            for (FJob& Job : Jobs)
+            {
+                if (Job.Status != EStatus::Pending || NumRunning >= NumWorkers)
+                {
+                    continue;
+                }
+
+                UVCETBakerComponent* Baker = Job.Baker.Get();
+                if (!Baker)
+                {
+                    Job.Fail(TEXT("Baker was destroyed"));
+                    continue;
+                }
+
+                UE_LOG(LogVCET, Display, TEXT("VCETBake: %s %s: Baking"), *Job.Map, *Job.Name);
+
+                Job.StartTime = FPlatformTime::Seconds();
+                Baker->StartBake();
+
+                if (!Baker->IsBakeInProgress())
+                {
+                    Job.Fail(TEXT("Bake did not start. Check its volume layer and enabled layers"));
+                    continue;
+                }
+
+                Job.Status = EStatus::Running;
+                NumRunning++;
+            }
+
+            const double Now = FPlatformTime::Seconds();
+            Tick(float(Now - LastTickTime));
+            LastTickTime = Now;
+
+            for (FJob& Job : Jobs)
+            {
+                if (Job.Status != EStatus::Running)
+                {
+                    continue;
+                }
+
+                UVCETBakerComponent* Baker = Job.Baker.Get();
+                if (!Baker)
+                {
+                    Job.Fail(TEXT("Baker was destroyed"));
+                    continue;
+                }
+
+                if (Baker->IsBakeInProgress())
+                {
+                    if (FPlatformTime::Seconds() - Job.StartTime > Timeout)
+                    {
+                        Job.Fail(FString::Printf(TEXT("Timed out after %.0fs"), Timeout));
+                    }
+                    continue;
+                }
+
+                Job.Seconds = FPlatformTime::Seconds() - Job.StartTime;
+
+                if (bSave)
+                {
+                    Job.NumTextures = Baker->SaveBakedTextures(bOverwrite).Num();
+                    if (Job.NumTextures == 0)
+                    {
+                        Job.Fail(TEXT("Bake produced no texture to save"));
+                        continue;
+                    }
+                }
+
+                Job.Status = EStatus::Succeeded;
+                UE_LOG(LogVCET, Display, TEXT("VCETBake: %s %s: Baked in %.3fs, saved %d textures"), *Job.Map, *Job.Name, Job.Seconds, Job.NumTextures);
+            }
+
+            FPlatformProcess::Sleep(0.001f);
+        }
+    }
+
+    // Timed out bakes keep running on the voxel workers, sampling the layers of the map: the map can only be unloaded once
+    // no baker has a bake in progress. Ticks until then, at most MaxWait seconds. Returns false if bakes are still running
+    bool WaitForBakes(const TArray<FJob>& Jobs, const double MaxWait)
+    {
+        const double StartTime = FPlatformTime::Seconds();
+        double LastTickTime = StartTime;
+
+        while (true)
+        {
+            const bool bBaking = Jobs.ContainsByPredicate([](const FJob& Job)
+            {
+                return Job.Baker.IsValid() && Job.Baker->IsBakeInProgress();
+            });
+            if (!bBaking)
+            {
+                return true;
+            }
+
+            const double Now = FPlatformTime::Seconds();
+            if (Now - StartTime > MaxWait)
+            {
+                return false;
+            }
+
+            Tick(float(Now - LastTickTime));
+            LastTickTime = Now;
+
+            FPlatformProcess::Sleep(0.001f);
+        }
+    }
+}
+
+UVCETBakeCommandlet::UVCETBakeCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 UVCETBakeCommandlet::Main(const FString& Params)
+{
+    using namespace VCETBake;
+
+    FString MapList;
+    if (!FParse::Value(*Params, TEXT("Maps="), MapList, false))
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCETBake: Missing -Maps=/Game/Maps/A,/Game/Maps/B"));
+        return 1;
+    }
+
+    TArray<FString> Maps;
+    MapList.ParseIntoArray(Maps, TEXT(","));
+
+    int32 NumWorkers = 2;
+    FParse::Value(*Params, TEXT("Workers="), NumWorkers);
+    NumWorkers = FMath::Max(NumWorkers, 1);
+
+    double Timeout = 600.;
+    FParse::Value(*Params, TEXT("Timeout="), Timeout);
+
+    double DrainTimeout = 60.;
+    FParse::Value(*Params, TEXT("DrainTimeout="), DrainTimeout);
+
+    const bool bOverwrite = FParse::Param(*Params, TEXT("Overwrite"));
+    const bool bSave = !FParse::Param(*Params, TEXT("NoSave"));
+
+    FString ReportPath;
+    if (!FParse::Value(*Params, TEXT("Report="), ReportPath))
+    {
+        ReportPath = FPaths::ProjectSavedDir() / TEXT("VCET") / TEXT("Bakes") /
+            FString::Printf(TEXT("BakeReport-%s.csv"), *FDateTime::Now().ToString());
+    }
+
+    UE_LOG(LogVCET, Display, TEXT("VCETBake: %d maps, %d workers, timeout %.0fs%s%s"), Maps.Num(), NumWorkers, Timeout,
+        bSave ? TEXT("") : TEXT(", not saving"),
+        bOverwrite ? TEXT(", overwriting") : TEXT(""));
+
+    TArray<FJob> AllJobs;
+    int32 NumFailedMaps = 0;
+
+    for (FString& Map : Maps)
+    {
+        Map.TrimStartAndEndInline();
+
+        UWorld* World = FPackageName::IsValidLongPackageName(Map) ? LoadMap(Map) : nullptr;
+        if (!World)
+        {
+            UE_LOG(LogVCET, Error, TEXT("VCETBake: Failed to load map %s"), *Map);
+            NumFailedMaps++;
+            continue;
+        }
+
+        TArray<FJob> Jobs;
+        for (TActorIterator<AActor> It(World); It; ++It)
+        {
+            TArray<UVCETBakerComponent*> Bakers;
+            It->GetComponents<UVCETBakerComponent>(Bakers);
+
+            for (UVCETBakerComponent* Baker : Bakers)
+            {
+                FJob& Job = Jobs.Emplace_GetRef();
+                Job.Map = Map;
+                Job.Name = Baker->GetBakerName();
+                Job.Class = Baker->GetClass()->GetName();
+                Job.Baker = Baker;
+            }
+        }
+
+        UE_LOG(LogVCET, Display, TEXT("VCETBake: %s: %d bakers"), *Map, Jobs.Num());
+
+        RunJobs(Jobs, NumWorkers, Timeout, bSave, bOverwrite);
+
+        if (WaitForBakes(Jobs, DrainTimeout))
+        {
+            UnloadMap(World);
+        }
+        else
+        {
+            // Destroying the world under the running bakes would crash the workers: leak it instead
+            UE_LOG(LogVCET, Error, TEXT("VCETBake: %s: Timed out bakes still running after %.0fs, keeping the map loaded"), *Map, DrainTimeout);
+        }
+
+        AllJobs.Append(Jobs);
+    }
+
+    int32 NumFailedJobs = 0;
+    FString Csv = TEXT("Map,Baker,Class,Status,Seconds,Textures,Error\n");
+    for (const FJob& Job : AllJobs)
+    {
+        const bool bSucceeded = Job.Status == EStatus::Succeeded;
+        NumFailedJobs += !bSucceeded;
+
+        Csv += FString::Printf(TEXT("%s,%s,%s,%s,%f,%d,%s\n"),
+            *VCET::EscapeCsvField(Job.Map),
+            *VCET::EscapeCsvField(Job.Name),
+            *VCET::EscapeCsvField(Job.Class),
+            bSucceeded ? TEXT("Succeeded") : TEXT("Failed"),
+            Job.Seconds,
+            Job.NumTextures,
+            *VCET::EscapeCsvField(Job.Error));
+    }
+
+    if (!FFileHelper::SaveStringToFile(Csv, *ReportPath))
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCETBake: Failed to write %s"), *ReportPath);
+    }
+
+    UE_LOG(LogVCET, Display, TEXT("VCETBake: %d bakers succeeded, %d failed, %d maps failed to load. Report: %s"),
+        AllJobs.Num() - NumFailedJobs, NumFailedJobs, NumFailedMaps, *ReportPath);
+
+    return NumFailedJobs > 0 || NumFailedMaps > 0 ? 1 : 0;
+}
@@ -0,0 +1,1331 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETBakeEngine.h"
+#include "VCETSyntheticLayer.h"
+#include "VCETChannelPacking.h"
+#include "VCETModule.h"
+#include "VCETSettings.h"
+#include "VoxelQuery.h"
+#include "VoxelLayers.h"
+#include "Surface/VoxelSurfaceTypeTable.h"
+#include "Buffer/VoxelFloatBuffers.h"
+#include "VoxelMetadata.h"
+#include "Algo/Sort.h"
+#include "VCETBakeMappingsImpl.ispc.generated.h"
+
+int32 GVCETBakeChunkSize = 65536;
+static FAutoConsoleVariableRef CVarVCETBakeChunkSize(
+    TEXT("vcet.Bake.ChunkSize"),
+    GVCETBakeChunkSize,
+    TEXT("Number of samples generated and queried per worker task when baking. 0 to query the whole texture in a single task. ")
+    TEXT("Coalesced bakes share queries for their chunks smaller than this only, full chunks are queried alone."));
+
+int32 GVCETBakeSampleOrder = 2;
+static FAutoConsoleVariableRef CVarVCETBakeSampleOrder(
+    TEXT("vcet.Bake.SampleOrder"),
+    GVCETBakeSampleOrder,
+    TEXT("Order in which the bakes query their samples. 0: texel order (X fastest), 1: bricks in texel order, 2: bricks along a Morton curve. ")
+    TEXT("Bricks keep the samples of a query close in every axis, and are scattered back to texel order after the query."));
+
+int32 GVCETBakeBrickSize = 16;
+static FAutoConsoleVariableRef CVarVCETBakeBrickSize(
+    TEXT("vcet.Bake.BrickSize"),
+    GVCETBakeBrickSize,
+    TEXT("Texels per side of the bricks of vcet.Bake.SampleOrder 1 and 2: BrickSize^2 texels for 2D bakes, BrickSize^3 for volumes."));
+
+int32 VCET::GetBakeChunkSize()
+{
+    return GVCETBakeChunkSize > 0 ? FMath::Max(GVCETBakeChunkSize, 1024) : MAX_int32;
+}
+
+VCET::EBakeSampleOrder VCET::GetBakeSampleOrder()
+{
+    return EBakeSampleOrder(FMath::Clamp(GVCETBakeSampleOrder, 0, 2));
+}
+
+int32 VCET::GetBakeBrickSize()
+{
+    return FMath::Clamp(GVCETBakeBrickSize, 2, 256);
+}
+
+VCET::FBakeChunks::FBakeChunks(const FIntVector& InGridSize, int32 InChunkSize, EBakeSampleOrder Order)
+    : GridSize(InGridSize)
+    , ChunkSize(InChunkSize)
+{
+    const int32 Num = GridSize.X * GridSize.Y * GridSize.Z;
+    if (Order == EBakeSampleOrder::Linear || Num == 0)
+    {
+        NumChunks = FMath::DivideAndRoundUp(Num, ChunkSize);
+        return;
+    }
+
+    const int32 Size = GetBakeBrickSize();
+    BrickSize = FIntVector(Size, Size, GridSize.Z > 1 ? Size : 1);
+    BricksPerChunk = FMath::Max(ChunkSize / (BrickSize.X * BrickSize.Y * BrickSize.Z), 1);
+
+    const FIntVector NumBricks(
+        FMath::DivideAndRoundUp(GridSize.X, BrickSize.X),
+        FMath::DivideAndRoundUp(GridSize.Y, BrickSize.Y),
+        FMath::DivideAndRoundUp(GridSize.Z, BrickSize.Z));
+
+    Bricks.Reserve(NumBricks.X * NumBricks.Y * NumBricks.Z);
+    for (int32 Z = 0; Z < NumBricks.Z; Z++)
+    {
+        for (int32 Y = 0; Y < NumBricks.Y; Y++)
+        {
+            for (int32 X = 0; X < NumBricks.X; X++)
+            {
+                Bricks.Add(FIntVector(X, Y, Z));
+            }
+        }
+    }
+
+    if (Order == EBakeSampleOrder::Morton)
+    {
+        // 16 bits per axis in 2D and 10 in 3D, plenty at the texture sizes a bake can allocate
+        const bool bIs3D = NumBricks.Z > 1;
+        Algo::SortBy(Bricks, [bIs3D](const FIntVector& Brick)
+        {
+            return bIs3D
+                ? FMath::MortonCode3(uint32(Brick.X)) | (FMath::MortonCode3(uint32(Brick.Y)) << 1) | (FMath::MortonCode3(uint32(Brick.Z)) << 2)
+                : FMath::MortonCode2(uint32(Brick.X)) | (FMath::MortonCode2(uint32(Brick.Y)) << 1);
+        });
+    }
+
+    NumChunks = FMath::DivideAndRoundUp(Bricks.Num(), BricksPerChunk);
+}
+
+void VCET::FBakeChunks::GetRuns(int32 ChunkIndex, TArray<FBakeRun>& OutRuns) const
+{
+    OutRuns.Reset();
+
+    if (Bricks.Num() == 0)
+    {
+        const int32 Start = ChunkIndex * ChunkSize;
+        OutRuns.Add({ Start, FMath::Min(ChunkSize, GridSize.X * GridSize.Y * GridSize.Z - Start) });
+        return;
+    }
+
+    const int32 FirstBrick = ChunkIndex * BricksPerChunk;
+    const int32 LastBrick = FMath::Min(FirstBrick + BricksPerChunk, Bricks.Num());
+    OutRuns.Reserve((LastBrick - FirstBrick) * BrickSize.Y * BrickSize.Z);
+
+    for (int32 BrickIndex = FirstBrick; BrickIndex < LastBrick; BrickIndex++)
+    {
+        // Bricks on the far edges are clipped to the grid
+        const FIntVector Min = Bricks[BrickIndex] * BrickSize;
+        const FIntVector Max = FIntVector(
+            FMath::Min(Min.X + BrickSize.X, GridSize.X),
+            FMath::Min(Min.Y + BrickSize.Y, GridSize.Y),
+            FMath::Min(Min.Z + BrickSize.Z, GridSize.Z));
+
+        for (int32 Z = Min.Z; Z < Max.Z; Z++)
+        {
+            for (int32 Y = Min.Y; Y < Max.Y; Y++)
+            {
+                OutRuns.Add({ (Z * GridSize.Y + Y) * GridSize.X + Min.X, Max.X - Min.X });
+            }
+        }
+    }
+}
+
+int32 VCET::FBakeChunks::GetNumSamples(int32 ChunkIndex) const
+{
+    if (Bricks.Num() == 0)
+    {
+        return FMath::Min(ChunkSize, GridSize.X * GridSize.Y * GridSize.Z - ChunkIndex * ChunkSize);
+    }
+
+    const int32 FirstBrick = ChunkIndex * BricksPerChunk;
+    const int32 LastBrick = FMath::Min(FirstBrick + BricksPerChunk, Bricks.Num());
+
+    int32 Count = 0;
+    for (int32 BrickIndex = FirstBrick; BrickIndex < LastBrick; BrickIndex++)
+    {
+        const FIntVector Min = Bricks[BrickIndex] * BrickSize;
+        Count +=
+            (FMath::Min(Min.X + BrickSize.X, GridSize.X) - Min.X) *
+            (FMath::Min(Min.Y + BrickSize.Y, GridSize.Y) - Min.Y) *
+            (FMath::Min(Min.Z + BrickSize.Z, GridSize.Z) - Min.Z);
+    }
+    return Count;
+}
+
+int32 VCET::GetQueryLOD(double TexelSize)
+{
+    const double VoxelSize = GetDefault<UVCETSettings>()->QueryLODVoxelSize;
+    if (VoxelSize <= 0. || TexelSize <= VoxelSize)
+    {
+        return 0;
+    }
+
+    // Largest LOD whose voxels are no bigger than a texel
+    return FMath::Clamp(FMath::FloorToInt32(FMath::Log2(TexelSize / VoxelSize)), 0, 24);
+}
+
+bool VCET::FBakeSource::Initialize(UWorld* World, const FVoxelStackVolumeLayer& VolumeLayer, UVoxelMetadata* Metadata)
+{
+    if (!World) return false;
+
+    MetadataType = EBakeMetadataType::None;
+    FloatRef.Reset();
+    ColorRef.Reset();
+    NormalRef.Reset();
+    Channels.Reset();
+    ChannelLayers.Reset();
+
+    if (Metadata)
+    {
+        if (auto* FloatMeta = Cast<UVoxelFloatMetadata>(Metadata))
+        {
+            MetadataType = EBakeMetadataType::Float;
+            FloatRef = FVoxelFloatMetadataRef(FloatMeta);
+        }
+        else if (auto* ColorMeta = Cast<UVoxelLinearColorMetadata>(Metadata))
+        {
+            MetadataType = EBakeMetadataType::LinearColor;
+            ColorRef = FVoxelLinearColorMetadataRef(ColorMeta);
+        }
+        else if (auto* NormalMeta = Cast<UVoxelNormalMetadata>(Metadata))
+        {
+            MetadataType = EBakeMetadataType::Normal;
+            NormalRef = FVoxelNormalMetadataRef(NormalMeta);
+        }
+    }
+
+    Layer = FVoxelWeakStackLayer(VolumeLayer);
+    SyntheticLayer.Reset();
+    Layers = FVoxelLayers::Get(World);
+    SurfaceTypeTable = FVoxelSurfaceTypeTable::Get();
+    return Layers.IsValid();
+}
+
+bool VCET::FBakeSource::InitializeChannels(UWorld* World, const FVoxelStackVolumeLayer& VolumeLayer, const FVCETChannelPacking& Packing)
+{
+    if (!Initialize(World, VolumeLayer, nullptr)) return false;
+
+    MetadataType = EBakeMetadataType::Packed;
+
+    for (int32 Index = 0; Index < 4; Index++)
+    {
+        const FVCETChannelSource& ChannelSource = Packing.GetChannel(Index);
+
+        FBakeChannel& Channel = Channels.AddDefaulted_GetRef();
+        Channel.Component = int32(ChannelSource.Component);
+        Channel.DefaultValue = ChannelSource.DefaultValue;
+
+        // Fold the remap into a single multiply-add
+        const float InputRange = ChannelSource.InputMax - ChannelSource.InputMin;
+        Channel.Scale = InputRange != 0.f ? (ChannelSource.OutputMax - ChannelSource.OutputMin) / InputRange : 0.f;
+        Channel.Offset = ChannelSource.OutputMin - ChannelSource.InputMin * Channel.Scale;
+        Channel.bClamp = ChannelSource.bClamp;
+        Channel.ClampMin = FMath::Min(ChannelSource.OutputMin, ChannelSource.OutputMax);
+        Channel.ClampMax = FMath::Max(ChannelSource.OutputMin, ChannelSource.OutputMax);
+
+        if (ChannelSource.Type == EVCETChannelSourceType::Distance)
+        {
+            Channel.Type = EBakeChannelType::Distance;
+        }
+        else if (ChannelSource.Type == EVCETChannelSourceType::Metadata)
+        {
+            if (auto* FloatMeta = Cast<UVoxelFloatMetadata>(ChannelSource.Metadata))
+            {
+                Channel.Type = EBakeChannelType::Float;
+                Channel.MetadataRef = FVoxelMetadataRef(FVoxelFloatMetadataRef(FloatMeta));
+            }
+            else if (auto* ColorMeta = Cast<UVoxelLinearColorMetadata>(ChannelSource.Metadata))
+            {
+                Channel.Type = EBakeChannelType::LinearColor;
+                Channel.MetadataRef = FVoxelMetadataRef(FVoxelLinearColorMetadataRef(ColorMeta));
+            }
+            else if (auto* NormalMeta = Cast<UVoxelNormalMetadata>(ChannelSource.Metadata))
+            {
+                Channel.Type = EBakeChannelType::Normal;
+                Channel.MetadataRef = FVoxelMetadataRef(FVoxelNormalMetadataRef(NormalMeta));
+                Channel.Component = FMath::Min(Channel.Component, 2);
+            }
+            else
+            {
+                UE_LOG(LogVCET, Warning, TEXT("VCET: Packed channel %d samples metadata but has none, or of an unsupported type. Using its default value"), Index);
+            }
+        }
+
+        if (Channel.Type == EBakeChannelType::Constant)
+        {
+            Channel.LayerIndex = INDEX_NONE;
+            continue;
+        }
+
+        Channel.LayerIndex = ChannelLayers.AddUnique(FVoxelWeakStackLayer(ChannelSource.Layer.IsValid() ? ChannelSource.Layer : VolumeLayer));
+    }
+
+    return true;
+}
+
+void VCET::FBakeSource::InitializeSynthetic(const TSharedRef<const FSyntheticLayer>& InSyntheticLayer, EBakeMetadataType InMetadataType)
+{
+    MetadataType = InMetadataType;
+    FloatRef.Reset();
+    ColorRef.Reset();
+    NormalRef.Reset();
+    Channels.Reset();
+    ChannelLayers.Reset();
+
+    Layer = {};
+    Layers.Reset();
+    SurfaceTypeTable.Reset();
+    SyntheticLayer = InSyntheticLayer;
+}
+
+bool VCET::FBakeSource::CanShareQueries(const FBakeSource& Other) const
+{
+    const auto IsSameChannel = [](const FBakeChannel& A, const FBakeChannel& B)
+    {
+        return
+            A.Type == B.Type &&
+            A.LayerIndex == B.LayerIndex &&
+            A.MetadataRef == B.MetadataRef &&
+            A.Component == B.Component &&
+            A.Scale == B.Scale &&
+            A.Offset == B.Offset &&
+            A.bClamp == B.bClamp &&
+            A.ClampMin == B.ClampMin &&
+            A.ClampMax == B.ClampMax &&
+            A.DefaultValue == B.DefaultValue;
+    };
+
+    if (Channels.Num() != Other.Channels.Num())
+    {
+        return false;
+    }
+    for (int32 Index = 0; Index < Channels.Num(); Index++)
+    {
+        if (!IsSameChannel(Channels[Index], Other.Channels[Index]))
+        {
+            return false;
+        }
+    }
+
+    return
+        Layer == Other.Layer &&
+        Layers == Other.Layers &&
+        SurfaceTypeTable == Other.SurfaceTypeTable &&
+        MetadataType == Other.MetadataType &&
+        FloatRef == Other.FloatRef &&
+        ColorRef == Other.ColorRef &&
+        NormalRef == Other.NormalRef &&
+        LOD == Other.LOD &&
+        SyntheticLayer == Other.SyntheticLayer &&
+        ChannelLayers == Other.ChannelLayers;
+}
+
+namespace VCET
+{
+    FORCEINLINE float ProcessValue(const FBakeProcessing& Processing, float Val)
+    {
+        if (Processing.bRemap) Val = (Val + 1.f) * 0.5f;
+        Val *= Processing.Multiplier;
+        if (Processing.bInvert) Val = 1.f - Val;
+        return Val;
+    }
+
+    // Every channel of color metadata, for bProcessColors
+    FORCEINLINE FLinearColor ProcessColor(const FBakeProcessing& Processing, const FLinearColor& Color)
+    {
+        return FLinearColor(
+            FMath::Clamp(ProcessValue(Processing, Color.R), 0.f, 1.f),
+            FMath::Clamp(ProcessValue(Processing, Color.G), 0.f, 1.f),
+            FMath::Clamp(ProcessValue(Processing, Color.B), 0.f, 1.f),
+            FMath::Clamp(ProcessValue(Processing, Color.A), 0.f, 1.f));
+    }
+
+    // Whether the samples go through Values and the global normalize/clamp pass
+    FORCEINLINE bool IsGrayscale(const FBakeSource& Source, const FBakeProcessing& Processing)
+    {
+        return
+            Source.MetadataType == EBakeMetadataType::None ||
+            (Source.MetadataType == EBakeMetadataType::Float && Processing.FloatMetadataMode == EBakeFloatMetadataMode::Grayscale);
+    }
+
+    // Samples Ref through the query, and returns its buffer or null if the metadata is invalid
+    const FVoxelBuffer* SampleMetadata(
+        FVoxelQuery& Query,
+        const FBakeSource& Source,
+        const FVoxelMetadataRef& Ref,
+        const FVoxelDoubleVectorBuffer& Positions,
+        TVoxelMap<FVoxelMetadataRef, TSharedRef<FVoxelBuffer>>& MetaBuffers,
+        FBakeData& Data)
+    {
+        VCET_BAKE_TIMED_SCOPE(Query, Data);
+        LLM_SCOPE_BYTAG(VCET_Query);
+
+        if (Ref.IsValid()) MetaBuffers.Add_EnsureNew(Ref, Ref.MakeDefaultBuffer(Positions.Num()));
+        Query.SampleVolumeLayer(Source.Layer, Positions, {}, MetaBuffers);
+
+        if (!Ref.IsValid()) return nullptr;
+        if (auto* Buf = MetaBuffers.Find(Ref)) return &Buf->Get();
+        return nullptr;
+    }
+
+    // Write stages, shared by the voxel buffers and the synthetic layer's arrays
+
+    template<typename BufferType>
+    void WriteDistanceSamples(const BufferType& Buffer, int32 Valid, int32 Start, FBakeData& Data)
+    {
+        VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+
+        float* Values = Data.Values.GetData() + Start;
+        for (int32 i = 0; i < Valid; i++) Values[i] = Buffer[i];
+    }
+
+    template<typename BufferType>
+    void WriteFloatSamples(const FBakeProcessing& Processing, const BufferType& Buffer, int32 Valid, int32 Start, FBakeData& Data)
+    {
+        if (Processing.FloatMetadataMode == EBakeFloatMetadataMode::Grayscale)
+        {
+            WriteDistanceSamples(Buffer, Valid, Start, Data);
+            return;
+        }
+
+        VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+
+        // Float metadata -> R channel only
+        FLinearColor* Colors = Data.Result.Colors.GetData() + Start;
+        for (int32 i = 0; i < Valid; i++) Colors[i] = FLinearColor(ProcessValue(Processing, Buffer[i]), 0.f, 0.f, 1.f);
+    }
+
+    template<typename BufferType>
+    void WriteColorSamples(const FBakeProcessing& Processing, const BufferType& Buffer, int32 Valid, int32 Start, FBakeData& Data)
+    {
+        VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+
+        FLinearColor* Colors = Data.Result.Colors.GetData() + Start;
+        for (int32 i = 0; i < Valid; i++)
+        {
+            const FLinearColor Color = Buffer[i];
+            Colors[i] = Processing.bProcessColors ? ProcessColor(Processing, Color) : Color;
+        }
+    }
+
+    template<typename BufferType>
+    void WriteNormalSamples(const BufferType& Buffer, int32 Valid, int32 Start, FBakeData& Data)
+    {
+        VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+
+        FLinearColor* Colors = Data.Result.Colors.GetData() + Start;
+        for (int32 i = 0; i < Valid; i++)
+        {
+            const FVector3f Normal = Buffer[i];
+            // Remap normal from [-1,1] to [0,1] for texture storage
+            Colors[i] = FLinearColor(Normal.X * 0.5f + 0.5f, Normal.Y * 0.5f + 0.5f, Normal.Z * 0.5f + 0.5f, 1.f);
+        }
+    }
+
+    // Writes one channel of samples [Start, Start + Valid), GetValue extracting the channel's value from a buffer element
+    template<typename BufferType, typename LambdaType>
+    void WriteChannelSamples(const FBakeChannel& Channel, int32 ChannelIndex, const BufferType& Buffer, int32 Valid, int32 Start, FBakeData& Data, LambdaType&& GetValue)
+    {
+        FLinearColor* Colors = Data.Result.Colors.GetData() + Start;
+        for (int32 i = 0; i < Valid; i++) Colors[i].Component(ChannelIndex) = Channel.Remap(GetValue(Buffer[i]));
+    }
+
+    // Writes the channels of one layer from its distance and metadata buffers. Returns the number of samples every buffer covers
+    int32 WritePackedChannels(
+        const FBakeSource& Source,
+        int32 LayerIndex,
+        const FVoxelFloatBuffer& Distance,
+        const TVoxelMap<FVoxelMetadataRef, TSharedRef<FVoxelBuffer>>& MetaBuffers,
+        int32 Count,
+        int32 Start,
+        FBakeData& Data)
+    {
+        VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+
+        int32 NumWritten = Count;
+        for (int32 ChannelIndex = 0; ChannelIndex < Source.Channels.Num(); ChannelIndex++)
+        {
+            const FBakeChannel& Channel = Source.Channels[ChannelIndex];
+            if (Channel.LayerIndex != LayerIndex) continue;
+
+            if (Channel.Type == EBakeChannelType::Distance)
+            {
+                WriteChannelSamples(Channel, ChannelIndex, Distance, Count, Start, Data, [](const float Value) { return Value; });
+                continue;
+            }
+
+            const TSharedRef<FVoxelBuffer>* Buffer = MetaBuffers.Find(Channel.MetadataRef.GetValue());
+            if (!Buffer)
+            {
+                NumWritten = 0;
+                continue;
+            }
+
+            const int32 Component = Channel.Component;
+            switch (Channel.Type)
+            {
+            case EBakeChannelType::Float:
+            {
+                const FVoxelFloatBuffer& FB = static_cast<const FVoxelFloatBuffer&>(Buffer->Get());
+                const int32 Valid = FMath::Min(FB.Num(), Count);
+                WriteChannelSamples(Channel, ChannelIndex, FB, Valid, Start, Data, [](const float Value) { return Value; });
+                NumWritten = FMath::Min(NumWritten, Valid);
+                break;
+            }
+            case EBakeChannelType::LinearColor:
+            {
+                const FVoxelLinearColorBuffer& CB = static_cast<const FVoxelLinearColorBuffer&>(Buffer->Get());
+                const int32 Valid = FMath::Min(CB.Num(), Count);
+                WriteChannelSamples(Channel, ChannelIndex, CB, Valid, Start, Data, [&](const FLinearColor& Color) { return Color.Component(Component); });
+                NumWritten = FMath::Min(NumWritten, Valid);
+                break;
+            }
+            case EBakeChannelType::Normal:
+            {
+                const FVoxelVectorBuffer& NB = static_cast<const FVoxelVectorBuffer&>(Buffer->Get());
+                const int32 Valid = FMath::Min(NB.Num(), Count);
+                WriteChannelSamples(Channel, ChannelIndex, NB, Valid, Start, Data, [&](const FVector3f& Normal) { return Normal[Component]; });
+                NumWritten = FMath::Min(NumWritten, Valid);
+                break;
+            }
+            default: break;
+            }
+        }
+        return NumWritten;
+    }
+
+    // Packed bakes: one query, one SampleVolumeLayer per distinct layer with all the metadata its channels use
+    void QueryPackedChunk(const FBakeSource& Source, const FVoxelDoubleVectorBuffer& Positions, int32 Start, FBakeData& Data)
+    {
+        const int32 Count = Positions.Num();
+
+        FVoxelQuery Query(Source.LOD, *Source.Layers, *Source.SurfaceTypeTable, FVoxelDependencyCollector::Null);
+
+        int32 NumWritten = Count;
+        for (int32 LayerIndex = 0; LayerIndex < Source.ChannelLayers.Num(); LayerIndex++)
+        {
+            TVoxelMap<FVoxelMetadataRef, TSharedRef<FVoxelBuffer>> MetaBuffers;
+
+            auto Distance = [&]
+            {
+                VCET_BAKE_TIMED_SCOPE(Query, Data);
+                LLM_SCOPE_BYTAG(VCET_Query);
+
+                for (const FBakeChannel& Channel : Source.Channels)
+                {
+                    if (Channel.LayerIndex != LayerIndex || !Channel.MetadataRef.IsSet()) continue;
+
+                    const FVoxelMetadataRef& Ref = Channel.MetadataRef.GetValue();
+                    if (Ref.IsValid() && !MetaBuffers.Contains(Ref)) MetaBuffers.Add_EnsureNew(Ref, Ref.MakeDefaultBuffer(Count));
+                }
+                return Query.SampleVolumeLayer(Source.ChannelLayers[LayerIndex], Positions, {}, MetaBuffers);
+            }();
+
+            NumWritten = FMath::Min(NumWritten, WritePackedChannels(Source, LayerIndex, Distance, MetaBuffers, Count, Start, Data));
+        }
+
+        Data.NumSkippedSamples += Count - NumWritten;
+    }
+
+    void QuerySyntheticPackedChunk(const FBakeSource& Source, const FVoxelDoubleVectorBuffer& Positions, int32 Start, FBakeData& Data)
+    {
+        const FSyntheticLayer& Layer = *Source.SyntheticLayer;
+        const int32 Count = Positions.Num();
+
+        LLM_SCOPE_BYTAG(VCET_Query);
+
+        // Each quantity is sampled once, whatever the number of channels using it
+        TArray<float> Distances;
+        TArray<float> Floats;
+        TArray<FLinearColor> Colors;
+        TArray<FVector3f> Normals;
+
+        for (int32 ChannelIndex = 0; ChannelIndex < Source.Channels.Num(); ChannelIndex++)
+        {
+            const FBakeChannel& Channel = Source.Channels[ChannelIndex];
+            const int32 Component = Channel.Component;
+
+            switch (Channel.Type)
+            {
+            case EBakeChannelType::Distance:
+            {
+                if (Distances.Num() == 0)
+                {
+                    VCET_BAKE_TIMED_SCOPE(Query, Data);
+                    Layer.SampleDistance(Positions, Distances);
+                }
+                VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+                WriteChannelSamples(Channel, ChannelIndex, Distances, Count, Start, Data, [](const float Value) { return Value; });
+                break;
+            }
+            case EBakeChannelType::Float:
+            {
+                if (Floats.Num() == 0)
+                {
+                    VCET_BAKE_TIMED_SCOPE(Query, Data);
+                    Layer.SampleFloat(Positions, Floats);
+                }
+                VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+                WriteChannelSamples(Channel, ChannelIndex, Floats, Count, Start, Data, [](const float Value) { return Value; });
+                break;
+            }
+            case EBakeChannelType::LinearColor:
+            {
+                if (Colors.Num() == 0)
+                {
+                    VCET_BAKE_TIMED_SCOPE(Query, Data);
+                    Layer.SampleColor(Positions, Colors);
+                }
+                VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+                WriteChannelSamples(Channel, ChannelIndex, Colors, Count, Start, Data, [&](const FLinearColor& Color) { return Color.Component(Component); });
+                break;
+            }
+            case EBakeChannelType::Normal:
+            {
+                if (Normals.Num() == 0)
+                {
+                    VCET_BAKE_TIMED_SCOPE(Query, Data);
+                    Layer.SampleNormal(Positions, Normals);
+                }
+                VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+                WriteChannelSamples(Channel, ChannelIndex, Normals, Count, Start, Data, [&](const FVector3f& Normal) { return Normal[Component]; });
+                break;
+            }
+            default: break;
+            }
+        }
+    }
+
+    void QuerySyntheticChunk(const FBakeSource& Source, const FBakeProcessing& Processing, const FVoxelDoubleVectorBuffer& Positions, int32 Start, FBakeData& Data)
+    {
+        const FSyntheticLayer& Layer = *Source.SyntheticLayer;
+        const int32 Count = Positions.Num();
+
+        LLM_SCOPE_BYTAG(VCET_Query);
+
+        switch (Source.MetadataType)
+        {
+        case EBakeMetadataType::Float:
+        {
+            TArray<float> Buffer;
+            {
+                VCET_BAKE_TIMED_SCOPE(Query, Data);
+                Layer.SampleFloat(Positions, Buffer);
+            }
+            WriteFloatSamples(Processing, Buffer, Count, Start, Data);
+            break;
+        }
+        case EBakeMetadataType::LinearColor:
+        {
+            TArray<FLinearColor> Buffer;
+            {
+                VCET_BAKE_TIMED_SCOPE(Query, Data);
+                Layer.SampleColor(Positions, Buffer);
+            }
+            WriteColorSamples(Processing, Buffer, Count, Start, Data);
+            break;
+        }
+        case EBakeMetadataType::Normal:
+        {
+            TArray<FVector3f> Buffer;
+            {
+                VCET_BAKE_TIMED_SCOPE(Query, Data);
+                Layer.SampleNormal(Positions, Buffer);
+            }
+            WriteNormalSamples(Buffer, Count, Start, Data);
+            break;
+        }
+        default:
+        case EBakeMetadataType::None:
+        {
+            TArray<float> Buffer;
+            {
+                VCET_BAKE_TIMED_SCOPE(Query, Data);
+                Layer.SampleDistance(Positions, Buffer);
+            }
+            WriteDistanceSamples(Buffer, Count, Start, Data);
+            break;
+        }
+        }
+    }
+}
+
+void VCET::BeginBake(const FBakeSource& Source, const FBakeProcessing& Processing, int32 Num, FBakeData& Data)
+{
+    LLM_SCOPE_BYTAG(VCET_Results);
+
+    Data.Result.Type = Source.MetadataType;
+
+    if (Source.MetadataType == EBakeMetadataType::Packed)
+    {
+        // Constant channels, and samples the metadata buffers don't cover, keep their default value
+        FLinearColor Default(0.f, 0.f, 0.f, 0.f);
+        for (int32 Index = 0; Index < Source.Channels.Num(); Index++)
+        {
+            Default.Component(Index) = Source.Channels[Index].DefaultValue;
+        }
+        Data.Result.Colors.Init(Default, Num);
+        return;
+    }
+
+    // Samples the metadata buffer doesn't cover stay transparent black
+    Data.Result.Colors.SetNumZeroed(Num);
+
+    if (IsGrayscale(Source, Processing))
+    {
+        Data.Values.SetNumZeroed(Num);
+    }
+}
+
+void VCET::QueryBakeChunk(const FBakeSource& Source, const FBakeProcessing& Processing, const FVoxelDoubleVectorBuffer& Positions, int32 Start, FBakeData& Data)
+{
+    AddBakeSamples(Positions.Num());
+
+    if (Source.MetadataType == EBakeMetadataType::Packed)
+    {
+        if (Source.SyntheticLayer)
+        {
+            QuerySyntheticPackedChunk(Source, Positions, Start, Data);
+        }
+        else
+        {
+            QueryPackedChunk(Source, Positions, Start, Data);
+        }
+        return;
+    }
+
+    if (Source.SyntheticLayer)
+    {
+        QuerySyntheticChunk(Source, Processing, Positions, Start, Data);
+        return;
+    }
+
+    const int32 Count = Positions.Num();
+
+    FVoxelQuery Query(Source.LOD, *Source.Layers, *Source.SurfaceTypeTable, FVoxelDependencyCollector::Null);
+    TVoxelMap<FVoxelMetadataRef, TSharedRef<FVoxelBuffer>> MetaBuffers;
+
+    // Samples the metadata buffer doesn't cover are skipped
+    int32 NumWritten = 0;
+
+    switch (Source.MetadataType)
+    {
+    case EBakeMetadataType::Float:
+    {
+        if (!Source.FloatRef.IsSet()) break;
+
+        if (auto* FB = static_cast<const FVoxelFloatBuffer*>(SampleMetadata(Query, Source, Source.FloatRef.GetValue(), Positions, MetaBuffers, Data)))
+        {
+            NumWritten = FMath::Min(FB->Num(), Count);
+            WriteFloatSamples(Processing, *FB, NumWritten, Start, Data);
+        }
+        break;
+    }
+    case EBakeMetadataType::LinearColor:
+    {
+        if (!Source.ColorRef.IsSet()) break;
+
+        if (auto* CB = static_cast<const FVoxelLinearColorBuffer*>(SampleMetadata(Query, Source, Source.ColorRef.GetValue(), Positions, MetaBuffers, Data)))
+        {
+            NumWritten = FMath::Min(CB->Num(), Count);
+            WriteColorSamples(Processing, *CB, NumWritten, Start, Data);
+        }
+        break;
+    }
+    case EBakeMetadataType::Normal:
+    {
+        if (!Source.NormalRef.IsSet()) break;
+
+        if (auto* NB = static_cast<const FVoxelVectorBuffer*>(SampleMetadata(Query, Source, Source.NormalRef.GetValue(), Positions, MetaBuffers, Data)))
+        {
+            NumWritten = FMath::Min(NB->Num(), Count);
+            WriteNormalSamples(*NB, NumWritten, Start, Data);
+        }
+        break;
+    }
+    default:
+    case EBakeMetadataType::None:
+    {
+        // No metadata - sample distance field
+        auto Dist = [&]
+        {
+            VCET_BAKE_TIMED_SCOPE(Query, Data);
+            LLM_SCOPE_BYTAG(VCET_Query);
+            return Query.SampleVolumeLayer(Source.Layer, Positions);
+        }();
+        NumWritten = Count;
+        WriteDistanceSamples(Dist, Count, Start, Data);
+        break;
+    }
+    }
+
+    Data.NumSkippedSamples += Count - NumWritten;
+}
+
+void VCET::QueryBakeRuns(const FBakeSource& Source, const FBakeProcessing& Processing, const FVoxelDoubleVectorBuffer& Positions, TConstArrayView<FBakeRun> Runs, FBakeData& Data)
+{
+    if (Runs.Num() == 1)
+    {
+        QueryBakeChunk(Source, Processing, Positions, Runs[0].Start, Data);
+        return;
+    }
+
+    // Query into chunk sized buffers in run order, then copy each run to its texels
+    FBakeData ChunkData;
+    BeginBake(Source, Processing, Positions.Num(), ChunkData);
+    QueryBakeChunk(Source, Processing, Positions, 0, ChunkData);
+
+    {
+        VCET_BAKE_TIMED_SCOPE(MetadataCopy, Data);
+
+        // Grayscale bakes only write values, FinishBake() makes the colors
+        const bool bGrayscale = IsGrayscale(Source, Processing);
+
+        int32 Offset = 0;
+        for (const FBakeRun& Run : Runs)
+        {
+            if (bGrayscale)
+            {
+                FMemory::Memcpy(&Data.Values[Run.Start], &ChunkData.Values[Offset], Run.Count * sizeof(float));
+            }
+            else
+            {
+                FMemory::Memcpy(&Data.Result.Colors[Run.Start], &ChunkData.Result.Colors[Offset], Run.Count * sizeof(FLinearColor));
+            }
+            Offset += Run.Count;
+        }
+    }
+
+    Data.Cycles.Query += ChunkData.Cycles.Query.load();
+    Data.Cycles.MetadataCopy += ChunkData.Cycles.MetadataCopy.load();
+    Data.NumSkippedSamples += ChunkData.NumSkippedSamples.load();
+}
+
+namespace VCET
+{
+    // Chunk ChunkIndex of job JobIndex of RunBakeJobs()
+    struct FBakeBatchPiece
+    {
+        int32 JobIndex = 0;
+        int32 ChunkIndex = 0;
+    };
+
+    // Writes samples [SharedStart, SharedStart + Run.Count) of a batch queried without processing to the texels of Run, with
+    // the processing the write stages would have applied. Only the first NumWritten samples were sampled
+    void WriteSharedSamples(const FBakeSource& Source, const FBakeProcessing& Processing, const FBakeData& SharedData, int32 SharedStart, int32 NumWritten, const FBakeRun& Run, FBakeData& Data)
+    {
+        if (IsGrayscale(Source, Processing))
+        {
+            // Processed by FinishBake()
+            FMemory::Memcpy(&Data.Values[Run.Start], &SharedData.Values[SharedStart], Run.Count * sizeof(float));
+            return;
+        }
+
+        const FLinearColor* SharedColors = SharedData.Result.Colors.GetData() + SharedStart;
+        FLinearColor* Colors = Data.Result.Colors.GetData() + Run.Start;
+
+        if (Source.MetadataType == EBakeMetadataType::Float)
+        {
+            for (int32 i = 0; i < NumWritten; i++) Colors[i] = FLinearColor(ProcessValue(Processing, SharedColors[i].R), 0.f, 0.f, 1.f);
+            return;
+        }
+        if (Source.MetadataType == EBakeMetadataType::LinearColor && Processing.bProcessColors)
+        {
+            for (int32 i = 0; i < NumWritten; i++) Colors[i] = ProcessColor(Processing, SharedColors[i]);
+            return;
+        }
+
+        // Normals and packed channels don't depend on the processing. Samples that weren't sampled have the same defaults
+        FMemory::Memcpy(Colors, SharedColors, Run.Count * sizeof(FLinearColor));
+    }
+
+    // Queries chunks of one or several jobs at once: their positions back to back, queried without processing,
+    // then each job processes its samples into its own data
+    void QuerySharedBatch(const FBakeSource& Source, TConstArrayView<TSharedRef<FBakeJob>> Jobs, TConstArrayView<FBakeBatchPiece> Batch)
+    {
+        TArray<TArray<FBakeRun>> PieceRuns;
+        PieceRuns.SetNum(Batch.Num());
+
+        int32 Count = 0;
+        for (int32 Index = 0; Index < Batch.Num(); Index++)
+        {
+            Jobs[Batch[Index].JobIndex]->Chunks->GetRuns(Batch[Index].ChunkIndex, PieceRuns[Index]);
+            Count += CountRunSamples(PieceRuns[Index]);
+        }
+
+        FVoxelDoubleVectorBuffer Positions;
+        {
+            VCET_BAKE_SCOPE(Positions);
+            LLM_SCOPE_BYTAG(VCET_Positions);
+
+            Positions.Allocate(Count);
+
+            int32 Offset = 0;
+            for (int32 Index = 0; Index < Batch.Num(); Index++)
+            {
+                FBakeJob& Job = *Jobs[Batch[Index].JobIndex];
+                FBakePhaseTimer Timer(Job.Data.Cycles.Positions);
+                Job.GenerateRunPositions(PieceRuns[Index], Positions, Offset);
+                Offset += CountRunSamples(PieceRuns[Index]);
+            }
+        }
+
+        // The jobs of a batch have the same float metadata mode, which decides where the raw samples go
+        FBakeProcessing SharedProcessing;
+        SharedProcessing.bRemap = false;
+        SharedProcessing.FloatMetadataMode = Jobs[Batch[0].JobIndex]->Processing.FloatMetadataMode;
+
+        FBakeData SharedData;
+        BeginBake(Source, SharedProcessing, Count, SharedData);
+        QueryBakeChunk(Source, SharedProcessing, Positions, 0, SharedData);
+
+        const int32 NumWritten = Count - int32(SharedData.NumSkippedSamples);
+
+        VCET_BAKE_SCOPE(MetadataCopy);
+
+        int32 Offset = 0;
+        for (int32 Index = 0; Index < Batch.Num(); Index++)
+        {
+            FBakeJob& Job = *Jobs[Batch[Index].JobIndex];
+            const int32 PieceCount = CountRunSamples(PieceRuns[Index]);
+            {
+                FBakePhaseTimer Timer(Job.Data.Cycles.MetadataCopy);
+
+                int32 RunOffset = Offset;
+                for (const FBakeRun& Run : PieceRuns[Index])
+                {
+                    WriteSharedSamples(Source, Job.Processing, SharedData, RunOffset, FMath::Clamp(NumWritten - RunOffset, 0, Run.Count), Run, Job.Data);
+                    RunOffset += Run.Count;
+                }
+            }
+
+            // The shared query is split between the jobs by sample count
+            Job.Data.Cycles.Query += SharedData.Cycles.Query * PieceCount / Count;
+            Job.Data.Cycles.MetadataCopy += SharedData.Cycles.MetadataCopy * PieceCount / Count;
+            Job.Data.NumSkippedSamples += PieceCount - FMath::Clamp(NumWritten - Offset, 0, PieceCount);
+
+            Offset += PieceCount;
+        }
+    }
+}
+
+int32 VCET::CountRunSamples(TConstArrayView<FBakeRun> Runs)
+{
+    int32 Count = 0;
+    for (const FBakeRun& Run : Runs)
+    {
+        Count += Run.Count;
+    }
+    return Count;
+}
+
+void VCET::RunBakeJobs(const FBakeSource& Source, TConstArrayView<TSharedRef<FBakeJob>> Jobs, TFunctionRef<void(int32 JobIndex, FBakeResult&& Result)> OnBaked)
+{
+    VOXEL_FUNCTION_COUNTER();
+
+    const double StartTime = FPlatformTime::Seconds();
+    const int32 ChunkSize = GetBakeChunkSize();
+
+    for (const TSharedRef<FBakeJob>& Job : Jobs)
+    {
+        {
+            VCET_BAKE_TIMED_SCOPE(Positions, Job->Data);
+            LLM_SCOPE_BYTAG(VCET_Positions);
+            Job->Prepare();
+        }
+        BeginBake(Source, Job->Processing, Job->Num(), Job->Data);
+    }
+
+    // Partial chunks of every job are packed into shared batches, each full chunk is a batch of its own
+    TArray<TArray<FBakeBatchPiece, TInlineAllocator<1>>> Batches;
+    {
+        int32 SharedBatch = INDEX_NONE;
+        int32 SharedBatchCount = 0;
+
+        for (int32 JobIndex = 0; JobIndex < Jobs.Num(); JobIndex++)
+        {
+            const FBakeJob& Job = *Jobs[JobIndex];
+            for (int32 ChunkIndex = 0; ChunkIndex < Job.Chunks->Num(); ChunkIndex++)
+            {
+                const int32 Count = Job.Chunks->GetNumSamples(ChunkIndex);
+                if (Count >= ChunkSize)
+                {
+                    Batches.AddDefaulted_GetRef().Add({ JobIndex, ChunkIndex });
+                    continue;
+                }
+
+                if (SharedBatch == INDEX_NONE ||
+                    SharedBatchCount + Count > ChunkSize ||
+                    Jobs[Batches[SharedBatch][0].JobIndex]->Processing.FloatMetadataMode != Job.Processing.FloatMetadataMode)
+                {
+                    SharedBatch = Batches.AddDefaulted();
+                    SharedBatchCount = 0;
+                }
+                Batches[SharedBatch].Add({ JobIndex, ChunkIndex });
+                SharedBatchCount += Count;
+            }
+        }
+    }
+
+    const int32 NumConcurrentChunks = FMath::Min(Batches.Num(), FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+
+    const auto FinishJob = [&](const int32 JobIndex)
+    {
+        FBakeJob& Job = *Jobs[JobIndex];
+
+        FBakeResult Result = FinishBake(Source, Job.Processing, Job.Data);
+        if (Job.Processing.bReduceColumns)
+        {
+            VCET_BAKE_TIMED_SCOPE(PostProcess, Job.Data);
+            ReduceBakeColumns(Job.Processing, Job.GetGridSize(), Result);
+        }
+        FillBakeTelemetry(Job.Data, NumConcurrentChunks, ChunkSize, Job.LaunchTime, StartTime, Result);
+        Result.Telemetry.QueryLOD = Source.LOD;
+        Result.Telemetry.NumCoalescedBakes = Jobs.Num();
+
+        OnBaked(JobIndex, MoveTemp(Result));
+    };
+
+    // Chunks each job still waits for. The worker finishing the last one completes the job
+    const TUniquePtr<std::atomic<int32>[]> NumChunksLeft = MakeUnique<std::atomic<int32>[]>(Jobs.Num());
+    for (int32 JobIndex = 0; JobIndex < Jobs.Num(); JobIndex++)
+    {
+        NumChunksLeft[JobIndex] = Jobs[JobIndex]->Chunks->Num();
+        if (NumChunksLeft[JobIndex] == 0)
+        {
+            FinishJob(JobIndex);
+        }
+    }
+
+    ParallelFor(Batches.Num(), [&](const int32 BatchIndex)
+    {
+        VOXEL_SCOPE_COUNTER("Bake chunk");
+
+        const TConstArrayView<FBakeBatchPiece> Batch = Batches[BatchIndex];
+        if (Batch.Num() > 1)
+        {
+            QuerySharedBatch(Source, Jobs, Batch);
+        }
+        else
+        {
+            FBakeJob& Job = *Jobs[Batch[0].JobIndex];
+
+            TArray<FBakeRun> Runs;
+            FVoxelDoubleVectorBuffer Positions;
+            {
+                VCET_BAKE_TIMED_SCOPE(Positions, Job.Data);
+                LLM_SCOPE_BYTAG(VCET_Positions);
+                Job.Chunks->GetRuns(Batch[0].ChunkIndex, Runs);
+                Positions.Allocate(CountRunSamples(Runs));
+                Job.GenerateRunPositions(Runs, Positions, 0);
+            }
+
+            QueryBakeRuns(Source, Job.Processing, Positions, Runs, Job.Data);
+        }
+
+        for (const FBakeBatchPiece& Piece : Batch)
+        {
+            if (--NumChunksLeft[Piece.JobIndex] == 0)
+            {
+                FinishJob(Piece.JobIndex);
+            }
+        }
+    });
+}
+
+TArray<VCET::FBakeResult> VCET::RunBakeJobs(const FBakeSource& Source, TConstArrayView<TSharedRef<FBakeJob>> Jobs)
+{
+    TArray<FBakeResult> Results;
+    Results.SetNum(Jobs.Num());
+
+    RunBakeJobs(Source, Jobs, [&](const int32 JobIndex, FBakeResult&& Result)
+    {
+        Results[JobIndex] = MoveTemp(Result);
+    });
+    return Results;
+}
+
+VCET::FBakeResult VCET::FinishBake(const FBakeSource& Source, const FBakeProcessing& Processing, FBakeData& Data)
+{
+    VOXEL_FUNCTION_COUNTER();
+    VCET_BAKE_TIMED_SCOPE(PostProcess, Data);
+
+    if (!IsGrayscale(Source, Processing))
+    {
+        return MoveTemp(Data.Result);
+    }
+
+    const int32 N = Data.Values.Num();
+    const int32 ChunkSize = FMath::Min(GetBakeChunkSize(), FMath::Max(N, 1));
+    const int32 NumChunks = FMath::DivideAndRoundUp(N, ChunkSize);
+
+    // First pass: remap and find min/max, per chunk
+    TArray<FFloatInterval> ChunkRanges;
+    ChunkRanges.Init(FFloatInterval(FLT_MAX, -FLT_MAX), NumChunks);
+
+    ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+    {
+        const int32 Start = ChunkIndex * ChunkSize;
+        const int32 End = FMath::Min(Start + ChunkSize, N);
+
+        float MinV = FLT_MAX, MaxV = -FLT_MAX;
+        for (int32 i = Start; i < End; i++)
+        {
+            const float Val = ProcessValue(Processing, Data.Values[i]);
+            Data.Values[i] = Val;
+            MinV = FMath::Min(MinV, Val);
+            MaxV = FMath::Max(MaxV, Val);
+        }
+        ChunkRanges[ChunkIndex] = FFloatInterval(MinV, MaxV);
+    });
+
+    float MinV = FLT_MAX, MaxV = -FLT_MAX;
+    for (const FFloatInterval& Range : ChunkRanges)
+    {
+        MinV = FMath::Min(MinV, Range.Min);
+        MaxV = FMath::Max(MaxV, Range.Max);
+    }
+
+    // Second pass: normalize if requested, else clamp to 0-1
+    const bool bNormalize = Processing.bNormalize && MaxV > MinV;
+    const float Range = MaxV - MinV;
+
+    ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+    {
+        const int32 Start = ChunkIndex * ChunkSize;
+        const int32 End = FMath::Min(Start + ChunkSize, N);
+
+        for (int32 i = Start; i < End; i++)
+        {
+            const float Val = bNormalize
+                ? (Data.Values[i] - MinV) / Range
+                : FMath::Clamp(Data.Values[i], 0.f, 1.f);
+            Data.Result.Colors[i] = FLinearColor(Val, Val, Val, 1.f);
+        }
+    });
+
+    return MoveTemp(Data.Result);
+}
+
+void VCET::ReduceBakeColumns(const FBakeProcessing& Processing, const FIntVector& GridSize, FBakeResult& Result)
+{
+    VOXEL_FUNCTION_COUNTER();
+    LLM_SCOPE_BYTAG(VCET_Results);
+
+    const int32 NumColumns = GridSize.X * GridSize.Y;
+    if (GridSize.Z <= 0 || Result.Colors.Num() != NumColumns * GridSize.Z)
+    {
+        return;
+    }
+
+    Result.Columns.SetNum(NumColumns);
+
+    const double SliceHeight = (Processing.ColumnTop - Processing.ColumnBottom) / GridSize.Z;
+    const int32 Channel = FMath::Clamp(Processing.ColumnChannel, 0, 3);
+
+    // One row of columns per task, walked slice by slice so that every read is contiguous along X
+    ParallelFor(GridSize.Y, [&](const int32 Y)
+    {
+        FVCETColumnReduction* Columns = Result.Columns.GetData() + Y * GridSize.X;
+        for (int32 X = 0; X < GridSize.X; X++)
+        {
+            Columns[X].MaxDensity = -MAX_flt;
+        }
+
+        for (int32 Z = 0; Z < GridSize.Z; Z++)
+        {
+            const float Height = float(Processing.ColumnBottom + (Z + 0.5) * SliceHeight);
+            const FLinearColor* Colors = Result.Colors.GetData() + (int64(Z) * GridSize.Y + Y) * GridSize.X;
+
+            for (int32 X = 0; X < GridSize.X; X++)
+            {
+                const float Density = Colors[X].Component(Channel);
+
+                FVCETColumnReduction& Column = Columns[X];
+                Column.IntegratedDensity += float(Density * SliceHeight);
+                Column.MaxDensity = FMath::Max(Column.MaxDensity, Density);
+
+                if (Density > Processing.ColumnThreshold)
+                {
+                    // Coverage counts the covered samples until the end
+                    if (Column.Coverage == 0.f)
+                    {
+                        Column.CloudBase = Height;
+                    }
+                    Column.CloudTop = Height;
+                    Column.Coverage += 1.f;
+                }
+            }
+        }
+
+        for (int32 X = 0; X < GridSize.X; X++)
+        {
+            Columns[X].Coverage /= GridSize.Z;
+        }
+    });
+}
+
+void VCET::FillBakeTelemetry(const FBakeData& Data, int32 NumConcurrentChunks, int32 ChunkSize, double LaunchTime, double StartTime, FBakeResult& Result)
+{
+    const auto ToMs = [](const uint64 Cycles) { return float(FPlatformTime::ToMilliseconds64(Cycles)); };
+
+    FVCETBakeTelemetry& Telemetry = Result.Telemetry;
+    Telemetry.LaunchTime = LaunchTime;
+    Telemetry.AsyncEndTime = FPlatformTime::Seconds();
+    Telemetry.QueueWaitMs = float((StartTime - LaunchTime) * 1000.);
+    Telemetry.PositionsMs = ToMs(Data.Cycles.Positions);
+    Telemetry.QueryMs = ToMs(Data.Cycles.Query);
+    Telemetry.MetadataCopyMs = ToMs(Data.Cycles.MetadataCopy);
+    Telemetry.PostProcessMs = ToMs(Data.Cycles.PostProcess);
+    Telemetry.NumSamples = Result.Colors.Num();
+    Telemetry.NumSkippedSamples = Data.NumSkippedSamples;
+
+    // Colors and values live for the whole bake, plus the position and metadata buffers of the chunks in flight
+    const int64 ChunkBytes = int64(FMath::Min(ChunkSize, Result.Colors.Num())) * (3 * sizeof(double) + sizeof(FLinearColor));
+    Telemetry.PeakMemoryBytes = Result.Colors.GetAllocatedSize() + Data.Values.GetAllocatedSize() + NumConcurrentChunks * ChunkBytes;
+}
+
+int64 VCET::EstimateBakeBytes(int32 Num)
+{
+    // Same terms as the telemetry's peak memory, plus the converted pixels (at most half floats for the baker render targets)
+    // and the chunk colors and values that brick ordered chunks scatter back
+    const int32 NumConcurrentChunks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+    const int64 ChunkBytes = int64(FMath::Min(GetBakeChunkSize(), Num)) * (3 * sizeof(double) + 2 * sizeof(FLinearColor) + sizeof(float));
+    return int64(Num) * (sizeof(FLinearColor) + sizeof(float) + 4 * sizeof(uint16)) + NumConcurrentChunks * ChunkBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VCET
+{
+    // Longitude in [-Pi, Pi) along X, one column per texel
+    void BuildLongitudeTables(int32 Num, double Offset, TArray<double>& OutCos, TArray<double>& OutSin)
+    {
+        OutCos.SetNumUninitialized(Num);
+        OutSin.SetNumUninitialized(Num);
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            const double Lon = (double(Index) + Offset) / Num * UE_DOUBLE_TWO_PI - UE_DOUBLE_PI;
+            FMath::SinCos(&OutSin[Index], &OutCos[Index], Lon);
+        }
+    }
+
+    // Latitude in [0, Pi] from the +Z pole, one row per texel
+    void BuildLatitudeTables(int32 Num, double Offset, double Divisor, TArray<double>& OutSin, TArray<double>& OutCos)
+    {
+        OutSin.SetNumUninitialized(Num);
+        OutCos.SetNumUninitialized(Num);
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            const double Lat = (double(Index) + Offset) / Divisor * UE_DOUBLE_PI;
+            FMath::SinCos(&OutSin[Index], &OutCos[Index], Lat);
+        }
+    }
+
+    // Num values from A to B. With bTexelCenters, the values are at the texel centers instead of the corners
+    void BuildAxisTable(int32 Num, double A, double B, bool bTexelCenters, TArray<double>& OutValues)
+    {
+        OutValues.SetNumUninitialized(Num);
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            const double Alpha = bTexelCenters
+                ? (double(Index) + 0.5) / Num
+                : double(Index) / (Num - 1);
+            OutValues[Index] = FMath::Lerp(A, B, Alpha);
+        }
+    }
+}
+
+void VCET::FPlanarBakeMapping::Prepare()
+{
+    BuildAxisTable(Width, Min.X, Max.X, false, ColumnX);
+    BuildAxisTable(Height, Min.Y, Max.Y, false, RowY);
+}
+
+void VCET::FPlanarBakeMapping::GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const
+{
+    ispc::VCETBake_GenerateGridPositions(Start, Count, Width, Height, ColumnX.GetData(), RowY.GetData(), &Z, OutX, OutY, OutZ);
+}
+
+double VCET::FPlanarBakeMapping::GetTexelSize() const
+{
+    return FMath::Max((Max.X - Min.X) / FMath::Max(Width - 1, 1), (Max.Y - Min.Y) / FMath::Max(Height - 1, 1));
+}
+
+void VCET::FEquirectBakeMapping::Prepare()
+{
+    // The longitude wraps, so the last column stops one texel short of the first. The latitude spans pole to pole
+    BuildLongitudeTables(Width, 0., CosLon, SinLon);
+    BuildLatitudeTables(Height, 0., Height - 1, SinLat, CosLat);
+}
+
+void VCET::FEquirectBakeMapping::GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const
+{
+    ispc::VCETBake_GenerateSphericalPositions(
+        Start, Count, Width, Height,
+        CosLon.GetData(), SinLon.GetData(), SinLat.GetData(), CosLat.GetData(), &Radius,
+        Center.X, Center.Y, Center.Z,
+        OutX, OutY, OutZ);
+}
+
+double VCET::FEquirectBakeMapping::GetTexelSize() const
+{
+    // Along the equator, where the longitude texels are the widest
+    return Radius * FMath::Max(UE_DOUBLE_TWO_PI / FMath::Max(Width, 1), UE_DOUBLE_PI / FMath::Max(Height - 1, 1));
+}
+
+void VCET::FCubeBakeMapping::Prepare()
+{
+    BuildAxisTable(FaceSize, -1., 1., true, Coords);
+}
+
+void VCET::FCubeBakeMapping::GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const
+{
+    ispc::VCETBake_GenerateCubePositions(Start, Count, FaceSize, Coords.GetData(), Radius, Center.X, Center.Y, Center.Z, OutX, OutY, OutZ);
+}
+
+double VCET::FCubeBakeMapping::GetTexelSize() const
+{
+    // At the face centers, where the texels are the widest
+    return Radius * 2. / FMath::Max(FaceSize, 1);
+}
+
+void VCET::FVolumeBakeMapping::Prepare()
+{
+    BuildAxisTable(Size, Min.X, Min.X + Extent.X, true, ColumnX);
+    BuildAxisTable(Size, Min.Y, Min.Y + Extent.Y, true, RowY);
+    BuildAxisTable(Size, Min.Z, Min.Z + Extent.Z, true, SliceZ);
+}
+
+void VCET::FVolumeBakeMapping::GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const
+{
+    ispc::VCETBake_GenerateGridPositions(Start, Count, Size, Size, ColumnX.GetData(), RowY.GetData(), SliceZ.GetData(), OutX, OutY, OutZ);
+}
+
+double VCET::FVolumeBakeMapping::GetTexelSize() const
+{
+    return Extent.GetMax() / FMath::Max(Size, 1);
+}
+
+void VCET::FShellBakeMapping::Prepare()
+{
+    BuildLongitudeTables(Size, 0.5, CosLon, SinLon);
+    BuildLatitudeTables(Size, 0.5, Size, SinLat, CosLat);
+    BuildAxisTable(Size, InnerRadius, OuterRadius, true, SliceRadius);
+}
+
+void VCET::FShellBakeMapping::GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const
+{
+    ispc::VCETBake_GenerateSphericalPositions(
+        Start, Count, Size, Size,
+        CosLon.GetData(), SinLon.GetData(), SinLat.GetData(), CosLat.GetData(), SliceRadius.GetData(),
+        Center.X, Center.Y, Center.Z,
+        OutX, OutY, OutZ);
+}
+
+double VCET::FShellBakeMapping::GetTexelSize() const
+{
+    // Along the equator of the outer slice, or across the slices if they are further apart
+    return FMath::Max(OuterRadius * UE_DOUBLE_TWO_PI, FMath::Abs(OuterRadius - InnerRadius)) / FMath::Max(Size, 1);
+}
@@ -0,0 +1,530 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelMinimal.h"
+#include "VoxelStackLayer.h"
+#include "VoxelFloatMetadata.h"
+#include "VoxelLinearColorMetadata.h"
+#include "VoxelNormalMetadata.h"
+#include "Buffer/VoxelDoubleBuffers.h"
+#include "Async/ParallelFor.h"
+#include "VCETBakeStats.h"
+#include "VCETBakeTelemetry.h"
+#include "VCETBakeMemory.h"
+#include "VCETColumnReduction.h"
+
+class FVoxelLayers;
+class FVoxelSurfaceTypeTable;
+class UVoxelMetadata;
+struct FVCETChannelPacking;
+
+namespace VCET
+{
+    struct FSyntheticLayer;
+}
+
+/**
+ * Bake engine shared by the VCET bakers.
+ *
+ * A bake is: generate sample positions from a mapping policy, query the volume layer,
+ * dispatch on the metadata type, process the values and hand colors back to the game thread
+ * for upload (see VCETBakeOutput.h). The sample range is split into chunks of
+ * vcet.Bake.ChunkSize samples, each generated and queried on its own worker thread.
+ *
+ * A mapping policy is any copyable type providing:
+ *   int32 Num() const;
+ *   void Prepare();
+ *   void GeneratePositions(int32 Start, int32 Count, double* X, double* Y, double* Z) const;
+ *   double GetTexelSize() const;
+ *   FIntVector GetGridSize() const;
+ * where sample I is texel I of the output texture, X fastest. Prepare() is called once per bake
+ * on the worker thread, before any GeneratePositions() call. GetTexelSize() is the largest spacing
+ * between neighbor samples in world units, for the query LOD (see GetQueryLOD()). GetGridSize() is
+ * the number of texels along X, Y and Z (Z is 1 for 2D textures), for the sample order (see FBakeChunks).
+ */
+// VCET_BAKE_SCOPE that also adds its cycles to Data.Cycles.Name, for the bake telemetry
+#define VCET_BAKE_TIMED_SCOPE(Name, Data) \
+    VCET_BAKE_SCOPE(Name); \
+    VCET::FBakePhaseTimer BakePhaseTimer_ ## Name(Data.Cycles.Name)
+
+namespace VCET
+{
+    /** Packed: one source per RGBA channel, see FBakeSource::Channels */
+    enum class EBakeMetadataType : uint8 { None, Float, LinearColor, Normal, Packed };
+
+    enum class EBakeChannelType : uint8 { Constant, Distance, Float, LinearColor, Normal };
+
+    /** One channel of a packed bake, resolved from a FVCETChannelSource on the game thread */
+    struct FBakeChannel
+    {
+        EBakeChannelType Type = EBakeChannelType::Constant;
+        /** Index in FBakeSource::ChannelLayers */
+        int32 LayerIndex = 0;
+        /** Unset for Constant and Distance, and for metadata of the synthetic layer */
+        TOptional<FVoxelMetadataRef> MetadataRef;
+        /** Component of color or normal metadata */
+        int32 Component = 0;
+
+        /** Value * Scale + Offset, then clamped between ClampMin and ClampMax if bClamp */
+        float Scale = 1.f;
+        float Offset = 0.f;
+        bool bClamp = false;
+        float ClampMin = 0.f;
+        float ClampMax = 1.f;
+        /** Constant channels, and samples the metadata buffer doesn't cover */
+        float DefaultValue = 0.f;
+
+        FORCEINLINE float Remap(float Value) const
+        {
+            Value = Value * Scale + Offset;
+            return bClamp ? FMath::Clamp(Value, ClampMin, ClampMax) : Value;
+        }
+    };
+
+    enum class EBakeFloatMetadataMode : uint8
+    {
+        /** Remap, multiply and invert, written to R only (Planar, Spherical) */
+        RedChannel,
+        /** Processed like the distance field: written to RGB, normalized or clamped (Volume) */
+        Grayscale
+    };
+
+    /** Layer and metadata to sample, captured on the game thread */
+    struct FBakeSource
+    {
+        FVoxelWeakStackLayer Layer;
+        TSharedPtr<FVoxelLayers> Layers;
+        TSharedPtr<FVoxelSurfaceTypeTable> SurfaceTypeTable;
+
+        EBakeMetadataType MetadataType = EBakeMetadataType::None;
+        TOptional<FVoxelFloatMetadataRef> FloatRef;
+        TOptional<FVoxelLinearColorMetadataRef> ColorRef;
+        TOptional<FVoxelNormalMetadataRef> NormalRef;
+
+        /** LOD of the queries, see GetQueryLOD() */
+        int32 LOD = 0;
+
+        /** If set, sampled instead of Layer (see VCETSyntheticLayer.h) */
+        TSharedPtr<const FSyntheticLayer> SyntheticLayer;
+
+        /** Packed bakes: the RGBA channels, and the distinct layers they sample (the synthetic layer is always layer 0) */
+        TArray<FBakeChannel, TFixedAllocator<4>> Channels;
+        TArray<FVoxelWeakStackLayer> ChannelLayers;
+
+        /** Detects the metadata type. Returns false if the world has no voxel layers */
+        bool Initialize(UWorld* World, const FVoxelStackVolumeLayer& VolumeLayer, UVoxelMetadata* Metadata);
+        /** Packed bake of the channels of Packing. Channels without a layer sample VolumeLayer. Returns false if the world has no voxel layers */
+        bool InitializeChannels(UWorld* World, const FVoxelStackVolumeLayer& VolumeLayer, const FVCETChannelPacking& Packing);
+        /** Samples an analytic layer instead of a voxel world, with MetadataType read from it */
+        void InitializeSynthetic(const TSharedRef<const FSyntheticLayer>& InSyntheticLayer, EBakeMetadataType InMetadataType);
+
+        /** Whether both sources sample the same layers, metadata and channels at the same LOD, so that their bakes can share queries */
+        bool CanShareQueries(const FBakeSource& Other) const;
+    };
+
+    /** The processing options of the bakers, plus the few places where the bakers historically differ */
+    struct FBakeProcessing
+    {
+        bool bRemap = true;
+        bool bNormalize = true;
+        bool bInvert = false;
+        float Multiplier = 1.f;
+
+        EBakeFloatMetadataMode FloatMetadataMode = EBakeFloatMetadataMode::RedChannel;
+        /** Remap, multiply, invert and clamp every channel of color metadata (Volume). Otherwise colors are written as sampled */
+        bool bProcessColors = false;
+
+        /** Volume bakes: reduce every Z column of the processed colors into FBakeResult::Columns, see ReduceBakeColumns() */
+        bool bReduceColumns = false;
+        /** Channel of the colors holding the density */
+        int32 ColumnChannel = 0;
+        /** Density above which a sample counts towards the coverage, cloud base and cloud top */
+        float ColumnThreshold = 0.f;
+        /** World heights of the bottom and top of the columns: Z for boxes, radius for shells */
+        double ColumnBottom = 0.;
+        double ColumnTop = 0.;
+    };
+
+    struct FBakeResult
+    {
+        TArray<FLinearColor> Colors;
+        EBakeMetadataType Type = EBakeMetadataType::None;
+        /** With FBakeProcessing::bReduceColumns, one reduction per XY column, X fastest */
+        TArray<FVCETColumnReduction> Columns;
+        /** Worker side of the bake telemetry. The game thread completes it (see UVCETBakerComponent::RecordBakeTelemetry) */
+        FVCETBakeTelemetry Telemetry;
+    };
+
+    /** Cycles spent in each worker phase, summed over the chunks */
+    struct FBakePhaseCycles
+    {
+        std::atomic<uint64> Positions = 0;
+        std::atomic<uint64> Query = 0;
+        std::atomic<uint64> MetadataCopy = 0;
+        std::atomic<uint64> PostProcess = 0;
+    };
+
+    /** Adds the cycles of its scope to a FBakePhaseCycles counter */
+    struct FBakePhaseTimer
+    {
+        std::atomic<uint64>& Cycles;
+        const uint64 StartCycles;
+
+        explicit FBakePhaseTimer(std::atomic<uint64>& InCycles)
+            : Cycles(InCycles)
+            , StartCycles(FPlatformTime::Cycles64())
+        {
+        }
+        ~FBakePhaseTimer()
+        {
+            Cycles += FPlatformTime::Cycles64() - StartCycles;
+        }
+    };
+
+    /** Samples buffered between the query and processing stages */
+    struct FBakeData
+    {
+        FBakeResult Result;
+        /** Raw distance or float metadata, for the grayscale modes that need the global min/max */
+        TArray<float> Values;
+
+        FBakePhaseCycles Cycles;
+        std::atomic<int64> NumSkippedSamples = 0;
+    };
+
+    int32 GetBakeChunkSize();
+
+    enum class EBakeSampleOrder : uint8
+    {
+        /** Texel order, X fastest */
+        Linear,
+        /** Bricks of GetBakeBrickSize() texels per side, in texel order */
+        Bricks,
+        /** Bricks along a Morton (Z-order) curve */
+        Morton
+    };
+
+    /** vcet.Bake.SampleOrder */
+    EBakeSampleOrder GetBakeSampleOrder();
+    /** vcet.Bake.BrickSize */
+    int32 GetBakeBrickSize();
+
+    /** Texels [Start, Start + Count) of the output texture */
+    struct FBakeRun
+    {
+        int32 Start = 0;
+        int32 Count = 0;
+    };
+
+    /**
+     * Splits the texels of a bake into chunks, and each chunk into the runs of texels it samples, in query order.
+     *
+     * Linear chunks are a single run of up to ChunkSize texels: in a volume, consecutive samples then span whole rows
+     * and slices, and neighbors along Y and Z are queried far apart. Brick chunks are made of whole bricks (as many as
+     * fit in ChunkSize texels), one run per brick row, so that a chunk samples a compact block of space, and along a
+     * Morton curve consecutive chunks are compact too. Each run being contiguous in the texture, the results of a
+     * chunk scatter back to texel order with one copy per run (see QueryBakeRuns())
+     */
+    class FBakeChunks
+    {
+    public:
+        FBakeChunks(const FIntVector& InGridSize, int32 InChunkSize, EBakeSampleOrder Order);
+
+        int32 Num() const { return NumChunks; }
+        /** Clears OutRuns and adds the runs of chunk ChunkIndex */
+        void GetRuns(int32 ChunkIndex, TArray<FBakeRun>& OutRuns) const;
+        /** Texels of chunk ChunkIndex, without building its runs */
+        int32 GetNumSamples(int32 ChunkIndex) const;
+
+    private:
+        FIntVector GridSize = FIntVector::ZeroValue;
+        int32 NumChunks = 0;
+
+        // Linear
+        int32 ChunkSize = 0;
+
+        // Bricks
+        FIntVector BrickSize = FIntVector::ZeroValue;
+        int32 BricksPerChunk = 0;
+        /** Coordinates of the bricks, in query order */
+        TArray<FIntVector> Bricks;
+    };
+
+    /**
+     * Query LOD whose voxels match texels of TexelSize world units: LOD N has voxels of UVCETSettings::QueryLODVoxelSize * 2^N.
+     * Graphs evaluated at a coarser LOD can skip the detail a bake couldn't resolve anyway, which is cheaper and aliases less
+     */
+    int32 GetQueryLOD(double TexelSize);
+
+    /** Prepares Data for Num samples */
+    void BeginBake(const FBakeSource& Source, const FBakeProcessing& Processing, int32 Num, FBakeData& Data);
+    /** Queries one chunk of positions and writes samples [Start, Start + Positions.Num()) of Data. Thread safe for disjoint chunks */
+    void QueryBakeChunk(const FBakeSource& Source, const FBakeProcessing& Processing, const FVoxelDoubleVectorBuffer& Positions, int32 Start, FBakeData& Data);
+    /**
+     * Queries the positions of the runs of a chunk, in order, and scatters the samples back to the texels of each run.
+     * Thread safe for disjoint chunks
+     */
+    void QueryBakeRuns(const FBakeSource& Source, const FBakeProcessing& Processing, const FVoxelDoubleVectorBuffer& Positions, TConstArrayView<FBakeRun> Runs, FBakeData& Data);
+    /** Processing that needs every sample (normalization), then returns the colors */
+    FBakeResult FinishBake(const FBakeSource& Source, const FBakeProcessing& Processing, FBakeData& Data);
+    /**
+     * Reduces the processed colors of a volume bake of GridSize texels along Z into Result.Columns, rows of columns in
+     * parallel. Replaces the planar bakes at many heights that 2D weather maps would otherwise need
+     */
+    void ReduceBakeColumns(const FBakeProcessing& Processing, const FIntVector& GridSize, FBakeResult& Result);
+    /** Fills the worker side of Result.Telemetry from Data. LaunchTime and StartTime are the FPlatformTime::Seconds() of the request and of the worker starting */
+    void FillBakeTelemetry(const FBakeData& Data, int32 NumConcurrentChunks, int32 ChunkSize, double LaunchTime, double StartTime, FBakeResult& Result);
+
+    int32 CountRunSamples(TConstArrayView<FBakeRun> Runs);
+
+    /** Positions of the texels of Runs, one after the other, written from sample Offset of Positions */
+    template<typename MappingType>
+    void GenerateRunPositions(const MappingType& Mapping, TConstArrayView<FBakeRun> Runs, FVoxelDoubleVectorBuffer& Positions, int32 Offset = 0)
+    {
+        checkSlow(Offset + CountRunSamples(Runs) <= Positions.Num());
+
+        for (const FBakeRun& Run : Runs)
+        {
+            Mapping.GeneratePositions(Run.Start, Run.Count, Positions.X.GetData() + Offset, Positions.Y.GetData() + Offset, Positions.Z.GetData() + Offset);
+            Offset += Run.Count;
+        }
+    }
+
+    /**
+     * One bake run by RunBakeJobs(): a mapping policy, type erased, with its processing and its samples.
+     * Made on the game thread by MakeBakeJob(), then only used by the worker running it
+     */
+    struct FBakeJob
+    {
+        FBakeProcessing Processing;
+        FBakeData Data;
+        /** Set by Prepare() */
+        TOptional<FBakeChunks> Chunks;
+        /** FPlatformTime::Seconds() of the request, before any wait for the memory budget */
+        double LaunchTime = 0.;
+
+        virtual ~FBakeJob() = default;
+
+        virtual int32 Num() const = 0;
+        virtual FIntVector GetGridSize() const = 0;
+        /** Mapping.Prepare(), then splits the texels into Chunks */
+        virtual void Prepare() = 0;
+        /** See VCET::GenerateRunPositions() */
+        virtual void GenerateRunPositions(TConstArrayView<FBakeRun> Runs, FVoxelDoubleVectorBuffer& Positions, int32 Offset) const = 0;
+    };
+
+    template<typename MappingType>
+    struct TBakeJob final : FBakeJob
+    {
+        MappingType Mapping;
+
+        virtual int32 Num() const override
+        {
+            return Mapping.Num();
+        }
+        virtual FIntVector GetGridSize() const override
+        {
+            return Mapping.GetGridSize();
+        }
+        virtual void Prepare() override
+        {
+            Mapping.Prepare();
+            Chunks.Emplace(Mapping.GetGridSize(), GetBakeChunkSize(), GetBakeSampleOrder());
+        }
+        virtual void GenerateRunPositions(TConstArrayView<FBakeRun> Runs, FVoxelDoubleVectorBuffer& Positions, int32 Offset) const override
+        {
+            VCET::GenerateRunPositions(Mapping, Runs, Positions, Offset);
+        }
+    };
+
+    template<typename MappingType>
+    TSharedRef<FBakeJob> MakeBakeJob(const MappingType& Mapping, const FBakeProcessing& Processing)
+    {
+        const TSharedRef<TBakeJob<MappingType>> Job = MakeShared<TBakeJob<MappingType>>();
+        Job->Mapping = Mapping;
+        Job->Processing = Processing;
+        Job->LaunchTime = FPlatformTime::Seconds();
+        return Job;
+    }
+
+    /**
+     * Runs bakes sampling the same Source on the calling worker thread, chunks in parallel, and calls OnBaked(JobIndex, Result)
+     * for each bake as soon as its own chunks are done, on the worker that finished its last one: a small bake doesn't wait
+     * for the large ones it runs with. OnBaked must be thread safe.
+     *
+     * Chunks of fewer than vcet.Bake.ChunkSize samples, whichever bake they belong to (small bakes, the last chunk of larger
+     * ones, brick chunks clipped by the grid), are packed together into batches of up to vcet.Bake.ChunkSize samples: the
+     * positions of a batch are sampled by one query without processing, then each bake processes and writes its own samples.
+     * Full chunks already make a full query and are queried alone. Per query costs (the FVoxelQuery, each SampleVolumeLayer
+     * call and its metadata buffers) are then paid once per batch rather than once per chunk
+     */
+    void RunBakeJobs(const FBakeSource& Source, TConstArrayView<TSharedRef<FBakeJob>> Jobs, TFunctionRef<void(int32 JobIndex, FBakeResult&& Result)> OnBaked);
+    /** Same as above, returning the results in order once every bake is done */
+    TArray<FBakeResult> RunBakeJobs(const FBakeSource& Source, TConstArrayView<TSharedRef<FBakeJob>> Jobs);
+
+    /**
+     * Runs Job with the other bakes requested this frame that can share its queries (see RunBakeJobs()), at the next tick
+     * of the core ticker, then calls OnBaked on the game thread. Right away and alone if vcet.Bake.Coalesce is 0.
+     * Game thread only (see VCETBakeCoalescer.h)
+     */
+    void LaunchCoalescedBake(const FBakeSource& Source, const TSharedRef<FBakeJob>& Job, TFunction<void(const FBakeResult&)> OnBaked);
+
+    /** Runs a whole bake on a voxel worker thread, alone */
+    template<typename MappingType>
+    TVoxelFuture<FBakeResult> BakeAsync(const FBakeSource& Source, const MappingType& Mapping, const FBakeProcessing& Processing)
+    {
+        BeginBakeInFlight();
+
+        const TSharedRef<FBakeJob> Job = MakeBakeJob(Mapping, Processing);
+
+        return Voxel::AsyncTask([Source, Job]() -> TVoxelFuture<FBakeResult>
+        {
+            VOXEL_FUNCTION_COUNTER();
+
+            TArray<FBakeResult> Results = RunBakeJobs(Source, MakeArrayView(&Job, 1));
+
+            EndBakeInFlight();
+            return MoveTemp(Results[0]);
+        });
+    }
+
+    /** Estimated peak memory of a bake of Num samples, from its launch to the upload of its colors, for the memory budget */
+    int64 EstimateBakeBytes(int32 Num);
+
+    /**
+     * Bakes once the memory budget allows it (see VCETBakeMemory.h), coalesced with the other bakes of the frame sharing its
+     * queries (see LaunchCoalescedBake()), then OnBaked(const FBakeResult&) on the game thread.
+     * Must be called from the game thread. Skipped if Owner is destroyed while the bake waits for memory
+     */
+    template<typename MappingType, typename LambdaType>
+    void BakeWithinBudget(const UObject* Owner, const FBakeSource& Source, const MappingType& Mapping, const FBakeProcessing& Processing, LambdaType&& OnBaked)
+    {
+        const int64 Bytes = EstimateBakeBytes(Mapping.Num());
+
+        // Made now so that its LaunchTime, and the telemetry's QueueWaitMs, include the wait for the budget
+        const TSharedRef<FBakeJob> Job = MakeBakeJob(Mapping, Processing);
+
+        FBakeMemoryBudget::Get().LaunchBake(Owner, Bytes, [Source, Job, Bytes, OnBaked = Forward<LambdaType>(OnBaked)]
+        {
+            LaunchCoalescedBake(Source, Job, [Bytes, OnBaked](const FBakeResult& Result)
+            {
+                OnBaked(Result);
+                FBakeMemoryBudget::Get().ReleaseBake(Bytes);
+            });
+        });
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+    // Mapping policies
+    //
+    // Positions are separable: Prepare() precomputes per-column, per-row and per-slice tables
+    // (including all the trig) once per bake, and GeneratePositions() runs an ISPC kernel over them
+    ///////////////////////////////////////////////////////////////////////////////
+
+    /** Horizontal XY grid at a fixed Z, texel corners on the bounds */
+    struct FPlanarBakeMapping
+    {
+        FVector2D Min = FVector2D::ZeroVector;
+        FVector2D Max = FVector2D::ZeroVector;
+        double Z = 0.;
+        int32 Width = 0;
+        int32 Height = 0;
+
+        int32 Num() const { return Width * Height; }
+        void Prepare();
+        void GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const;
+        double GetTexelSize() const;
+        FIntVector GetGridSize() const { return FIntVector(Width, Height, 1); }
+
+    private:
+        TArray<double> ColumnX;
+        TArray<double> RowY;
+    };
+
+    /** Equirectangular (lat/long) sphere surface: longitude along X, latitude (pole to pole) along Y */
+    struct FEquirectBakeMapping
+    {
+        FVector Center = FVector::ZeroVector;
+        double Radius = 0.;
+        int32 Width = 0;
+        int32 Height = 0;
+
+        int32 Num() const { return Width * Height; }
+        void Prepare();
+        void GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const;
+        double GetTexelSize() const;
+        FIntVector GetGridSize() const { return FIntVector(Width, Height, 1); }
+
+    private:
+        TArray<double> CosLon;
+        TArray<double> SinLon;
+        TArray<double> SinLat;
+        TArray<double> CosLat;
+    };
+
+    /**
+     * Sphere surface through a cube map: six square faces side by side (+X, -X, +Y, -Y, +Z, -Z, D3D orientation),
+     * each FaceSize x FaceSize texels. Spreads texels far more evenly than equirect near the poles
+     */
+    struct FCubeBakeMapping
+    {
+        FVector Center = FVector::ZeroVector;
+        double Radius = 0.;
+        int32 FaceSize = 0;
+
+        int32 Num() const { return 6 * FaceSize * FaceSize; }
+        void Prepare();
+        void GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const;
+        double GetTexelSize() const;
+        FIntVector GetGridSize() const { return FIntVector(6 * FaceSize, FaceSize, 1); }
+
+    private:
+        TArray<double> Coords;
+    };
+
+    /** Box volume sampled at texel centers, Size^3 texels */
+    struct FVolumeBakeMapping
+    {
+        FVector Min = FVector::ZeroVector;
+        FVector Extent = FVector::ZeroVector;
+        int32 Size = 0;
+
+        int32 Num() const { return Size * Size * Size; }
+        void Prepare();
+        void GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const;
+        double GetTexelSize() const;
+        FIntVector GetGridSize() const { return FIntVector(Size); }
+
+    private:
+        TArray<double> ColumnX;
+        TArray<double> RowY;
+        TArray<double> SliceZ;
+    };
+
+    /**
+     * Spherical shell sampled at texel centers, Size^3 texels:
+     * longitude along X, latitude (pole to pole) along Y, radius from InnerRadius to OuterRadius along Z
+     */
+    struct FShellBakeMapping
+    {
+        FVector Center = FVector::ZeroVector;
+        double InnerRadius = 0.;
+        double OuterRadius = 0.;
+        int32 Size = 0;
+
+        int32 Num() const { return Size * Size * Size; }
+        void Prepare();
+        void GeneratePositions(int32 Start, int32 Count, double* OutX, double* OutY, double* OutZ) const;
+        double GetTexelSize() const;
+        FIntVector GetGridSize() const { return FIntVector(Size); }
+
+    private:
+        TArray<double> CosLon;
+        TArray<double> SinLon;
+        TArray<double> SinLat;
+        TArray<double> CosLat;
+        TArray<double> SliceRadius;
+    };
+}
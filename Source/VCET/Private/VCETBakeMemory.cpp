@@ -0,0 +1,255 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETBakeMemory.h"
+#include "VCETBakerComponent.h"
+#include "VCETSettings.h"
+#include "VCETModule.h"
+
+int32 GVCETBakeMemoryBudgetMB = -1;
+static FAutoConsoleVariableRef CVarVCETBakeMemoryBudgetMB(
+    TEXT("vcet.Bake.MemoryBudget.MB"),
+    GVCETBakeMemoryBudgetMB,
+    TEXT("Budget of the memory owned by VCET (cached colors, render targets, procedural noise tiles, bakes in flight), in MB. 0 is unlimited, -1 uses the project setting."));
+
+int32 GVCETBakeMemoryBudgetSpillCaches = -1;
+static FAutoConsoleVariableRef CVarVCETBakeMemoryBudgetSpillCaches(
+    TEXT("vcet.Bake.MemoryBudget.SpillCaches"),
+    GVCETBakeMemoryBudgetSpillCaches,
+    TEXT("1: write evicted cached colors to Saved/VCET/Cache, 0: drop them. -1 uses the project setting."));
+
+static FAutoConsoleCommand CmdVCETBakeDumpMemory(
+    TEXT("vcet.Bake.DumpMemory"),
+    TEXT("Logs the memory owned by each VCET baker against the memory budget."),
+    FConsoleCommandDelegate::CreateLambda([]
+    {
+        VCET::FBakeMemoryBudget::Get().DumpMemory();
+    }));
+
+VCET::FBakeMemoryBudget& VCET::FBakeMemoryBudget::Get()
+{
+    static FBakeMemoryBudget Budget;
+    return Budget;
+}
+
+int64 VCET::FBakeMemoryBudget::GetBudgetBytes()
+{
+    const int32 BudgetMB = GVCETBakeMemoryBudgetMB >= 0 ? GVCETBakeMemoryBudgetMB : GetDefault<UVCETSettings>()->MemoryBudgetMB;
+    return FMath::Max(BudgetMB, 0) * int64(1024 * 1024);
+}
+
+bool VCET::FBakeMemoryBudget::ShouldSpillEvictedCaches()
+{
+    return GVCETBakeMemoryBudgetSpillCaches >= 0 ? GVCETBakeMemoryBudgetSpillCaches != 0 : GetDefault<UVCETSettings>()->bSpillEvictedCaches;
+}
+
+void VCET::FBakeMemoryBudget::RegisterBaker(UVCETBakerComponent* Baker)
+{
+    check(IsInGameThread());
+    Bakers.AddUnique(Baker);
+}
+
+void VCET::FBakeMemoryBudget::UnregisterBaker(UVCETBakerComponent* Baker)
+{
+    check(IsInGameThread());
+    Bakers.RemoveAllSwap([&](const TWeakObjectPtr<UVCETBakerComponent>& Other) { return Other == Baker || !Other.IsValid(); });
+}
+
+int64 VCET::FBakeMemoryBudget::GetCachedBytes() const
+{
+    int64 Bytes = 0;
+    for (const TWeakObjectPtr<UVCETBakerComponent>& Baker : Bakers)
+    {
+        if (Baker.IsValid())
+        {
+            Bytes += Baker->GetCachedColorsBytes();
+        }
+    }
+    return Bytes;
+}
+
+int64 VCET::FBakeMemoryBudget::GetRenderTargetBytes() const
+{
+    int64 Bytes = 0;
+    for (const TWeakObjectPtr<UVCETBakerComponent>& Baker : Bakers)
+    {
+        if (Baker.IsValid())
+        {
+            Bytes += Baker->GetRenderTargetBytes();
+        }
+    }
+    return Bytes;
+}
+
+void VCET::FBakeMemoryBudget::LaunchBake(const UObject* Owner, int64 Bytes, TFunction<void()> Launch)
+{
+    check(IsInGameThread());
+
+    // Waiting bakes go first, so that a small bake can't starve a large one
+    if (PendingBakes.Num() > 0 || !MakeRoom(Bytes))
+    {
+        UE_LOG(LogVCET, Verbose, TEXT("VCET: Bake of %s waits for %.1f MB, over the memory budget"), *GetNameSafe(Owner), Bytes / double(1024 * 1024));
+        PendingBakes.Add({ Owner, Bytes, MoveTemp(Launch) });
+        return;
+    }
+
+    StartBake(Bytes, Launch);
+}
+
+void VCET::FBakeMemoryBudget::ReleaseBake(int64 Bytes)
+{
+    check(IsInGameThread());
+    ensure(NumInFlight > 0);
+
+    InFlightBytes -= Bytes;
+    NumInFlight--;
+
+    // The bake just cached its colors
+    MakeRoom(0);
+    LaunchPendingBakes();
+}
+
+void VCET::FBakeMemoryBudget::ReserveCache(int64 Bytes)
+{
+    check(IsInGameThread());
+
+    if (!MakeRoom(Bytes))
+    {
+        UE_LOG(LogVCET, Verbose, TEXT("VCET: Reloading %.1f MB of cached colors over the memory budget until the bakes in flight finish"), Bytes / double(1024 * 1024));
+    }
+}
+
+int64 VCET::FBakeMemoryBudget::EvictCaches(int64 BytesToFree)
+{
+    check(IsInGameThread());
+
+    // Tiles first: they are rebuilt by a tile bake on next use, while evicted colors need a rebake or a reload from disk
+    int64 BytesFreed = EvictNoiseTiles(BytesToFree);
+    if (BytesFreed > 0)
+    {
+        UE_LOG(LogVCET, Log, TEXT("VCET: Freed %.1f MB of procedural noise tiles to stay within the memory budget"), BytesFreed / double(1024 * 1024));
+    }
+    if (BytesFreed >= BytesToFree)
+    {
+        return BytesFreed;
+    }
+
+    struct FCacheRef
+    {
+        UVCETBakerComponent* Baker;
+        FName Output;
+        double LastUseTime;
+    };
+    TArray<FCacheRef> Caches;
+    for (const TWeakObjectPtr<UVCETBakerComponent>& WeakBaker : Bakers)
+    {
+        UVCETBakerComponent* Baker = WeakBaker.Get();
+        if (!Baker) continue;
+
+        for (const TPair<FName, FVCETBakeCache>& It : Baker->CachedColors)
+        {
+            if (It.Value.Colors.Num() > 0)
+            {
+                Caches.Add({ Baker, It.Key, It.Value.LastUseTime });
+            }
+        }
+    }
+    Caches.Sort([](const FCacheRef& A, const FCacheRef& B) { return A.LastUseTime < B.LastUseTime; });
+
+    const bool bSpill = ShouldSpillEvictedCaches();
+
+    for (const FCacheRef& Cache : Caches)
+    {
+        if (BytesFreed >= BytesToFree) break;
+
+        const int64 Bytes = Cache.Baker->EvictCachedColors(Cache.Output, bSpill);
+        BytesFreed += Bytes;
+
+        UE_LOG(LogVCET, Log, TEXT("VCET: %s cached colors of %s.%s (%.1f MB) to stay within the memory budget"),
+            bSpill ? TEXT("Spilled") : TEXT("Dropped"),
+            *Cache.Baker->GetBakerName(),
+            *Cache.Output.ToString(),
+            Bytes / double(1024 * 1024));
+    }
+    return BytesFreed;
+}
+
+bool VCET::FBakeMemoryBudget::MakeRoom(int64 Bytes)
+{
+    const int64 BudgetBytes = GetBudgetBytes();
+    if (BudgetBytes <= 0)
+    {
+        return true;
+    }
+
+    int64 OverBudget = GetUsedBytes() + Bytes - BudgetBytes;
+    if (OverBudget > 0)
+    {
+        OverBudget -= EvictCaches(OverBudget);
+    }
+    if (OverBudget <= 0)
+    {
+        return true;
+    }
+
+    if (NumInFlight == 0)
+    {
+        // Nothing to wait for: render targets alone exceed the budget, or the bake itself does
+        UE_LOG(LogVCET, Warning, TEXT("VCET: Memory budget exceeded by %.1f MB with no bake in flight, baking anyway. Raise vcet.Bake.MemoryBudget.MB or lower the bake resolutions"),
+            OverBudget / double(1024 * 1024));
+        return true;
+    }
+    return false;
+}
+
+void VCET::FBakeMemoryBudget::StartBake(int64 Bytes, TFunction<void()>& Launch)
+{
+    InFlightBytes += Bytes;
+    NumInFlight++;
+    Launch();
+}
+
+void VCET::FBakeMemoryBudget::LaunchPendingBakes()
+{
+    while (PendingBakes.Num() > 0)
+    {
+        if (!PendingBakes[0].Owner.IsValid())
+        {
+            PendingBakes.RemoveAt(0);
+            continue;
+        }
+        if (!MakeRoom(PendingBakes[0].Bytes))
+        {
+            return;
+        }
+
+        FPendingBake Bake = MoveTemp(PendingBakes[0]);
+        PendingBakes.RemoveAt(0);
+        StartBake(Bake.Bytes, Bake.Launch);
+    }
+}
+
+void VCET::FBakeMemoryBudget::DumpMemory() const
+{
+    const auto ToMB = [](const int64 Bytes) { return Bytes / double(1024 * 1024); };
+
+    const int64 BudgetBytes = GetBudgetBytes();
+    UE_LOG(LogVCET, Log, TEXT("VCET memory: %.1f MB used of %s (cached colors %.1f MB, render targets %.1f MB, noise tiles %.1f MB, %d bakes in flight %.1f MB, %d bakes waiting)"),
+        ToMB(GetUsedBytes()),
+        BudgetBytes > 0 ? *FString::Printf(TEXT("%.1f MB"), ToMB(BudgetBytes)) : TEXT("unlimited"),
+        ToMB(GetCachedBytes()),
+        ToMB(GetRenderTargetBytes()),
+        ToMB(GetNoiseTileCacheBytes()),
+        NumInFlight,
+        ToMB(InFlightBytes),
+        PendingBakes.Num());
+
+    for (const TWeakObjectPtr<UVCETBakerComponent>& Baker : Bakers)
+    {
+        if (!Baker.IsValid()) continue;
+
+        UE_LOG(LogVCET, Log, TEXT("    %s: cached colors %.1f MB, render targets %.1f MB"),
+            *Baker->GetBakerName(),
+            ToMB(Baker->GetCachedColorsBytes()),
+            ToMB(Baker->GetRenderTargetBytes()));
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UVCETBakerComponent;
+
+namespace VCET
+{
+    /** Bytes held by the procedural noise tile cache (VCETProceduralNoiseTileNodes.cpp). Thread safe */
+    int64 GetNoiseTileCacheBytes();
+    /** Frees the least recently used procedural noise tiles until BytesToFree are freed. Returns the bytes freed. Thread safe */
+    int64 EvictNoiseTiles(int64 BytesToFree);
+
+    /**
+     * Global budget of the memory owned by the VCET bakers (UVCETSettings::MemoryBudgetMB, vcet.Bake.MemoryBudget.MB).
+     *
+     * Tracks the cached colors and the render targets of every registered baker, the procedural noise tiles, plus an estimate
+     * of each bake in flight. A bake that doesn't fit first frees the least recently used noise tiles, which only cost a tile
+     * bake to rebuild, then evicts the least recently used cached colors of all bakers (spilled to disk or dropped, see
+     * UVCETSettings::bSpillEvictedCaches), then waits for the bakes in flight to release their memory. Bakes are never
+     * refused: with nothing in flight to wait for, a bake over budget is launched anyway.
+     *
+     * Game thread only.
+     */
+    class FBakeMemoryBudget
+    {
+    public:
+        static FBakeMemoryBudget& Get();
+
+        /** In bytes, 0 if unlimited */
+        static int64 GetBudgetBytes();
+        static bool ShouldSpillEvictedCaches();
+
+        void RegisterBaker(UVCETBakerComponent* Baker);
+        void UnregisterBaker(UVCETBakerComponent* Baker);
+
+        /** Resident cached colors of the registered bakers */
+        int64 GetCachedBytes() const;
+        /** Render targets created by the registered bakers */
+        int64 GetRenderTargetBytes() const;
+        int64 GetInFlightBytes() const { return InFlightBytes; }
+        int64 GetUsedBytes() const { return GetCachedBytes() + GetRenderTargetBytes() + GetNoiseTileCacheBytes() + InFlightBytes; }
+
+        /**
+         * Reserves Bytes and calls Launch once they fit in the budget, now or when bakes in flight release theirs.
+         * Bakes are launched in request order. Launch is skipped if Owner was destroyed meanwhile.
+         * Every launched bake must call ReleaseBake() with the same Bytes once done
+         */
+        void LaunchBake(const UObject* Owner, int64 Bytes, TFunction<void()> Launch);
+        /** Releases the memory of a bake once its results are cached and uploaded, then launches the waiting bakes that fit */
+        void ReleaseBake(int64 Bytes);
+        /**
+         * Makes room for Bytes of cached colors about to be reloaded from disk, evicting other noise tiles and caches.
+         * A reload can't wait for the bakes in flight: if evicting isn't enough it goes over budget, until the next
+         * bake released frees the difference
+         */
+        void ReserveCache(int64 Bytes);
+
+        /** Evicts the least recently used noise tiles, then cached colors, until BytesToFree are freed. Returns the bytes freed */
+        int64 EvictCaches(int64 BytesToFree);
+
+        void DumpMemory() const;
+
+    private:
+        struct FPendingBake
+        {
+            TWeakObjectPtr<const UObject> Owner;
+            int64 Bytes = 0;
+            TFunction<void()> Launch;
+        };
+
+        TArray<TWeakObjectPtr<UVCETBakerComponent>> Bakers;
+        TArray<FPendingBake> PendingBakes;
+        int64 InFlightBytes = 0;
+        int32 NumInFlight = 0;
+
+        /** Evicts caches until Bytes more fit. Returns false if they don't and bakes in flight can free memory */
+        bool MakeRoom(int64 Bytes);
+        void StartBake(int64 Bytes, TFunction<void()>& Launch);
+        void LaunchPendingBakes();
+    };
+}
@@ -0,0 +1,486 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETBakeOutput.h"
+#include "VCETBakeStats.h"
+#include "VCETBakeTelemetry.h"
+#include "VCETModule.h"
+#include "Engine/Texture2D.h"
+#include "Engine/VolumeTexture.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTargetVolume.h"
+#include "TextureResource.h"
+#include "RenderingThread.h"
+#include "UObject/SavePackage.h"
+#include "Misc/PackageName.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Misc/App.h"
+
+int32 VCET::ConvertColorsToPixelFormat(const TArray<FLinearColor>& Colors, EPixelFormat Format, TArray<uint8>& OutData)
+{
+    VCET_BAKE_SCOPE(Conversion);
+    LLM_SCOPE_BYTAG(VCET_Conversion);
+
+    const int32 N = Colors.Num();
+
+    switch (Format)
+    {
+    case PF_FloatRGBA:
+    {
+        // RGBA 16-bit float
+        OutData.SetNumUninitialized(N * sizeof(FFloat16Color));
+        FFloat16Color* Dest = reinterpret_cast<FFloat16Color*>(OutData.GetData());
+        for (int32 i = 0; i < N; i++) Dest[i] = FFloat16Color(Colors[i]);
+        return sizeof(FFloat16Color);
+    }
+    case PF_A32B32G32R32F:
+    {
+        // RGBA 32-bit float, the FLinearColor layout
+        OutData.SetNumUninitialized(N * sizeof(FLinearColor));
+        FMemory::Memcpy(OutData.GetData(), Colors.GetData(), N * sizeof(FLinearColor));
+        return sizeof(FLinearColor);
+    }
+    case PF_B8G8R8A8:
+    {
+        // BGRA 8-bit, the FColor layout
+        OutData.SetNumUninitialized(N * sizeof(FColor));
+        FColor* Dest = reinterpret_cast<FColor*>(OutData.GetData());
+        for (int32 i = 0; i < N; i++) Dest[i] = Colors[i].ToFColor(false);
+        return sizeof(FColor);
+    }
+    case PF_R16F:
+    {
+        // Single channel 16-bit float - use R channel only
+        OutData.SetNumUninitialized(N * sizeof(FFloat16));
+        FFloat16* Dest = reinterpret_cast<FFloat16*>(OutData.GetData());
+        for (int32 i = 0; i < N; i++) Dest[i] = FFloat16(Colors[i].R);
+        return sizeof(FFloat16);
+    }
+    case PF_G8:
+    {
+        // Single channel 8-bit - use R channel only
+        OutData.SetNumUninitialized(N);
+        uint8* Dest = OutData.GetData();
+        for (int32 i = 0; i < N; i++) Dest[i] = uint8(FMath::Clamp(Colors[i].R * 255.f, 0.f, 255.f));
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+namespace VCET
+{
+    void AddConversionTelemetry(FVCETBakeTelemetry* Telemetry, double StartTime, const TArray<FLinearColor>& Colors, const TArray<uint8>& Data)
+    {
+        if (!Telemetry) return;
+
+        Telemetry->ConversionMs += float((FPlatformTime::Seconds() - StartTime) * 1000.);
+        Telemetry->BytesUploaded += Data.Num();
+        Telemetry->PeakMemoryBytes = FMath::Max<int64>(Telemetry->PeakMemoryBytes, Colors.GetAllocatedSize() + Data.GetAllocatedSize());
+    }
+}
+
+void VCET::WriteColorToRenderTarget(UTextureRenderTarget2D* RT, const TArray<FLinearColor>& Colors, int32 Width, int32 Height, FVCETBakeTelemetry* Telemetry)
+{
+    if (!RT || Colors.Num() != Width * Height) return;
+    // Headless (commandlets, -nullrhi): nothing to upload to, the bakers still keep their colors for static assets
+    if (!FApp::CanEverRender()) return;
+
+    // Convert to the layout the RHI expects for the render target's format.
+    // RTF_RGBA8 is PF_B8G8R8A8, anything that isn't float is written as such
+    const EPixelFormat Format = RT->GetFormat();
+    const double StartTime = FPlatformTime::Seconds();
+    TSharedRef<TArray<uint8>> Data = MakeShared<TArray<uint8>>();
+    const int32 BytesPerPixel = ConvertColorsToPixelFormat(
+        Colors,
+        Format == PF_FloatRGBA || Format == PF_A32B32G32R32F ? Format : PF_B8G8R8A8,
+        *Data);
+    AddConversionTelemetry(Telemetry, StartTime, Colors, *Data);
+
+    TWeakObjectPtr<UTextureRenderTarget2D> WRT = RT;
+    AsyncTask(ENamedThreads::GameThread, [WRT, Data, Width, Height, BytesPerPixel]()
+    {
+        VCET_BAKE_SCOPE(GameThread);
+
+        if (auto* R = WRT.Get(); R && IsValid(R))
+        {
+            UploadToRenderTarget(R, Data, BytesPerPixel, Width, Height);
+        }
+    });
+}
+
+void VCET::UploadToRenderTarget(UTextureRenderTarget2D* RT, const TSharedRef<TArray<uint8>>& Data, int32 BytesPerPixel, int32 Width, int32 Height)
+{
+    LLM_SCOPE_BYTAG(VCET_RenderTargets);
+
+    RT->UpdateResourceImmediate(true);
+    if (auto* Res = RT->GameThread_GetRenderTargetResource())
+    {
+        FUpdateTextureRegion2D Rgn(0, 0, 0, 0, Width, Height);
+        ENQUEUE_RENDER_COMMAND(VCETWriteColor)([Res, Data, Width, BytesPerPixel, Rgn](FRHICommandListImmediate&)
+        {
+            VCET_BAKE_SCOPE(Upload);
+
+            FRHITexture* Tex = Res->GetRenderTargetTexture();
+            if (Tex)
+            {
+                PRAGMA_DISABLE_DEPRECATION_WARNINGS
+                RHIUpdateTexture2D(Tex, 0, Rgn, Width * BytesPerPixel, Data->GetData());
+                PRAGMA_ENABLE_DEPRECATION_WARNINGS
+                AddBakeBytesUploaded(Data->Num());
+            }
+        });
+    }
+}
+
+void VCET::WriteColorToVolumeRenderTarget(UTextureRenderTargetVolume* RT, const TArray<FLinearColor>& ColorData, int32 Size, FVCETBakeTelemetry* Telemetry)
+{
+    if (!RT || ColorData.Num() == 0) return;
+    if (!FApp::CanEverRender()) return;
+
+    const int32 TotalVoxels = Size * Size * Size;
+
+    if (ColorData.Num() != TotalVoxels)
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCET: Volume data size mismatch! Expected %d, got %d"), TotalVoxels, ColorData.Num());
+        return;
+    }
+
+    // Query the ACTUAL format from the render target
+    const EPixelFormat ActualFormat = RT->GetFormat();
+
+    UE_LOG(LogVCET, Verbose, TEXT("VCET: Detected volume format %d (%s) with %d bytes per pixel"),
+        (int)ActualFormat, GPixelFormats[ActualFormat].Name, GPixelFormats[ActualFormat].BlockBytes);
+
+    // Convert color data to match the texture's actual format
+    const double StartTime = FPlatformTime::Seconds();
+    TSharedRef<TArray<uint8>> DataPtr = MakeShared<TArray<uint8>>();
+    const int32 BytesPerPixel = ConvertColorsToPixelFormat(ColorData, ActualFormat, *DataPtr);
+    AddConversionTelemetry(Telemetry, StartTime, ColorData, *DataPtr);
+    if (BytesPerPixel == 0)
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCET: Unsupported volume texture format %d (%s)!"),
+            (int)ActualFormat, GPixelFormats[ActualFormat].Name);
+        return;
+    }
+
+    UE_LOG(LogVCET, Verbose, TEXT("VCET: Prepared %d voxels, %d bytes total"),
+        TotalVoxels, DataPtr->Num());
+
+    UploadToVolumeRenderTarget(RT, DataPtr, BytesPerPixel, Size);
+}
+
+void VCET::UploadToVolumeRenderTarget(UTextureRenderTargetVolume* RT, const TSharedRef<TArray<uint8>>& DataPtr, int32 BytesPerPixel, int32 Size)
+{
+    // Make sure the resource is initialized
+    LLM_SCOPE_BYTAG(VCET_RenderTargets);
+    RT->UpdateResourceImmediate(true);
+
+    // For single-slice uploads to avoid pitch issues, we'll upload one XY slice at a time
+    const uint32 SliceSize = Size * Size * BytesPerPixel;
+
+    // Enqueue render command
+    ENQUEUE_RENDER_COMMAND(UpdateVolumeTextureSliced)(
+        [RT, DataPtr, Size, BytesPerPixel, SliceSize](FRHICommandListImmediate& RHICmdList)
+    {
+        VCET_BAKE_SCOPE(Upload);
+
+        if (!RT || !IsValid(RT)) return;
+
+        FTextureRenderTargetResource* Resource = RT->GetRenderTargetResource();
+        if (!Resource) return;
+
+        FRHITexture* Texture = Resource->GetRenderTargetTexture();
+        if (!Texture) return;
+
+        // Get the ACTUAL pixel format from the texture - this is what D3D12 allocated
+        const EPixelFormat ActualFormat = Texture->GetFormat();
+        const FPixelFormatInfo& FormatInfo = GPixelFormats[ActualFormat];
+
+        // Calculate what D3D12 expects for row pitch based on the actual texture format
+        // This accounts for block compression and other format-specific requirements
+        const uint32 ActualBytesPerPixel = FormatInfo.BlockBytes;
+        const uint32 BlockSizeX = FormatInfo.BlockSizeX;
+        const uint32 BlockSizeY = FormatInfo.BlockSizeY;
+
+        // Calculate row pitch accounting for block sizes
+        const uint32 NumBlocksX = FMath::DivideAndRoundUp((uint32)Size, BlockSizeX);
+        const uint32 NumBlocksY = FMath::DivideAndRoundUp((uint32)Size, BlockSizeY);
+        const uint32 DestRowPitch = NumBlocksX * ActualBytesPerPixel;
+
+        // Our source data pitch (tightly packed)
+        const uint32 SourceRowPitch = Size * BytesPerPixel;
+        const uint32 SourceSlicePitch = SourceRowPitch * Size;
+
+        // Log format info for debugging (should now match perfectly)
+        UE_LOG(LogVCET, Verbose, TEXT("VCET: ActualFormat=%d ActualBPP=%d SourceBPP=%d DestRowPitch=%d SourceRowPitch=%d"),
+            (int)ActualFormat, ActualBytesPerPixel, BytesPerPixel, DestRowPitch, SourceRowPitch);
+
+        // Check if we need format conversion or can upload directly
+        const bool bNeedsConversion = (ActualBytesPerPixel != BytesPerPixel) || (DestRowPitch != SourceRowPitch);
+
+        if (!bNeedsConversion)
+        {
+            // Perfect match - upload directly slice by slice
+            for (int32 Z = 0; Z < Size; ++Z)
+            {
+                const uint8* SliceData = DataPtr->GetData() + Z * SourceSlicePitch;
+
+                FUpdateTextureRegion3D Region(
+                    0, 0, Z,        // DestX, DestY, DestZ
+                    0, 0, 0,        // SourceX, SourceY, SourceZ
+                    Size, Size, 1   // Width, Height, Depth (1 slice)
+                );
+
+                PRAGMA_DISABLE_DEPRECATION_WARNINGS
+                RHIUpdateTexture3D(
+                    Texture,
+                    0,              // Mip index
+                    Region,
+                    DestRowPitch,       // Source row pitch (what D3D12 expects)
+                    DestRowPitch * NumBlocksY,     // Source depth pitch
+                    SliceData
+                );
+                PRAGMA_ENABLE_DEPRECATION_WARNINGS
+            }
+            AddBakeBytesUploaded(DataPtr->Num());
+        }
+        else
+        {
+            // Need to reformat data to match destination - create aligned buffer per slice
+            TArray<uint8> ConvertedSliceData;
+            const uint32 DestSliceSize = DestRowPitch * NumBlocksY;
+            ConvertedSliceData.SetNumZeroed(DestSliceSize);
+
+            for (int32 Z = 0; Z < Size; ++Z)
+            {
+                const uint8* SourceSliceData = DataPtr->GetData() + Z * SourceSlicePitch;
+
+                // Copy/convert each row
+                if (ActualBytesPerPixel == BytesPerPixel)
+                {
+                    // Same bytes per pixel, just different pitch - copy with padding
+                    for (int32 Y = 0; Y < Size; ++Y)
+                    {
+                        FMemory::Memcpy(
+                            ConvertedSliceData.GetData() + Y * DestRowPitch,
+                            SourceSliceData + Y * SourceRowPitch,
+                            SourceRowPitch
+                        );
+                    }
+                }
+                else
+                {
+                    // Format mismatch - need conversion (shouldn't happen if Init() uses matching format)
+                    UE_LOG(LogVCET, Error, TEXT("VCET: Format mismatch! Expected %d BPP but got %d BPP"),
+                        ActualBytesPerPixel, BytesPerPixel);
+                    return;
+                }
+
+                FUpdateTextureRegion3D Region(
+                    0, 0, Z,        // DestX, DestY, DestZ
+                    0, 0, 0,        // SourceX, SourceY, SourceZ
+                    Size, Size, 1   // Width, Height, Depth (1 slice)
+                );
+
+                PRAGMA_DISABLE_DEPRECATION_WARNINGS
+                RHIUpdateTexture3D(
+                    Texture,
+                    0,              // Mip index
+                    Region,
+                    DestRowPitch,       // Source row pitch (what D3D12 expects)
+                    DestSliceSize,      // Source depth pitch
+                    ConvertedSliceData.GetData()
+                );
+                PRAGMA_ENABLE_DEPRECATION_WARNINGS
+            }
+            AddBakeBytesUploaded(int64(DestSliceSize) * Size);
+        }
+    });
+}
+
+FString VCET::GetUniqueAssetName(const FString& PackagePath, const FString& BaseName)
+{
+    FString UniqueName = BaseName;
+    int32 Suffix = 1;
+
+    // Check if asset exists and increment suffix until we find a unique name
+    while (true)
+    {
+        FString TestPackageName = PackagePath + TEXT("/") + UniqueName;
+
+        // Check if package exists
+        if (!FPackageName::DoesPackageExist(TestPackageName))
+        {
+            break;
+        }
+
+        // Try next suffix
+        UniqueName = FString::Printf(TEXT("%s_%03d"), *BaseName, Suffix);
+        Suffix++;
+
+        // Safety check to avoid infinite loop
+        if (Suffix > 999)
+        {
+            UE_LOG(LogVCET, Warning, TEXT("VCET: Reached maximum suffix count (999), using timestamp"));
+            UniqueName = FString::Printf(TEXT("%s_%lld"), *BaseName, FDateTime::Now().GetTicks());
+            break;
+        }
+    }
+
+    return UniqueName;
+}
+
+namespace VCET
+{
+    // Creates the package and the texture object of a static asset. TextureType is UTexture2D or UVolumeTexture
+    template<typename TextureType>
+    TextureType* CreateStaticTextureObject(const FString& InPackagePath, const FString& BaseName, bool bReplaceExisting, UPackage*& OutPackage)
+    {
+        // Ensure output path is valid
+        FString PackagePath = InPackagePath;
+        if (PackagePath.IsEmpty())
+        {
+            PackagePath = TEXT("/Game/VCET/Textures");
+        }
+
+        // Remove trailing slash
+        PackagePath.RemoveFromEnd(TEXT("/"));
+
+        // Get unique asset name
+        const FString UniqueName = bReplaceExisting ? BaseName : GetUniqueAssetName(PackagePath, BaseName);
+        const FString PackageName = PackagePath + TEXT("/") + UniqueName;
+
+        UE_LOG(LogVCET, Log, TEXT("VCET: Creating static texture at %s"), *PackageName);
+
+        // Create package
+        OutPackage = CreatePackage(*PackageName);
+        if (!OutPackage)
+        {
+            UE_LOG(LogVCET, Error, TEXT("VCET: Failed to create package %s"), *PackageName);
+            return nullptr;
+        }
+
+        OutPackage->FullyLoad();
+
+        // Reuse the texture of a previous bake so the package keeps a single asset
+        if (TextureType* Existing = FindObject<TextureType>(OutPackage, *UniqueName))
+        {
+            Existing->Modify();
+            return Existing;
+        }
+
+        TextureType* Texture = NewObject<TextureType>(OutPackage, *UniqueName, RF_Public | RF_Standalone);
+        if (!Texture)
+        {
+            UE_LOG(LogVCET, Error, TEXT("VCET: Failed to create %s object"), *TextureType::StaticClass()->GetName());
+        }
+        return Texture;
+    }
+
+    // Fills the texture source with RGBA16F data, then updates and saves the asset
+    void FinishStaticTexture(UTexture* Texture, UPackage* Package, const TArray<FLinearColor>& Colors)
+    {
+#if WITH_EDITOR
+        VCET_BAKE_SCOPE(AssetSave);
+        LLM_SCOPE_BYTAG(VCET_AssetSource);
+
+        // Convert FLinearColor data to FFloat16Color for the texture
+        TArray<FFloat16Color> Float16Data;
+        Float16Data.SetNumUninitialized(Colors.Num());
+
+        for (int32 i = 0; i < Colors.Num(); i++)
+        {
+            Float16Data[i] = FFloat16Color(Colors[i]);
+        }
+
+        // Copy data to texture source
+        uint8* DestData = Texture->Source.LockMip(0);
+        FMemory::Memcpy(DestData, Float16Data.GetData(), Float16Data.Num() * sizeof(FFloat16Color));
+        Texture->Source.UnlockMip(0);
+
+        // Set texture properties
+        Texture->SRGB = false;
+        Texture->CompressionSettings = TC_HDR;
+        Texture->MipGenSettings = TMGS_NoMipmaps;
+
+        // Update the texture
+        Texture->UpdateResource();
+
+        // Mark package as dirty
+        Package->MarkPackageDirty();
+
+        // Save the package
+        const FString FilePath = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+        FSavePackageArgs SaveArgs;
+        SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+        SaveArgs.SaveFlags = SAVE_NoError;
+
+        if (UPackage::SavePackage(Package, Texture, *FilePath, SaveArgs))
+        {
+            UE_LOG(LogVCET, Log, TEXT("VCET: Successfully saved static texture to %s"), *FilePath);
+
+            // Notify asset registry
+            FAssetRegistryModule::AssetCreated(Texture);
+        }
+        else
+        {
+            UE_LOG(LogVCET, Error, TEXT("VCET: Failed to save package to %s"), *FilePath);
+        }
+#endif
+    }
+}
+
+UTexture2D* VCET::CreateStaticTexture2D(const TArray<FLinearColor>& Colors, int32 Width, int32 Height, const FString& PackagePath, const FString& BaseName, bool bReplaceExisting)
+{
+#if WITH_EDITOR
+    if (Colors.Num() != Width * Height)
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCET: Texture data size mismatch! Expected %d, got %d"), Width * Height, Colors.Num());
+        return nullptr;
+    }
+
+    UPackage* Package = nullptr;
+    LLM_SCOPE_BYTAG(VCET_AssetSource);
+    UTexture2D* Texture = CreateStaticTextureObject<UTexture2D>(PackagePath, BaseName, bReplaceExisting, Package);
+    if (!Texture) return nullptr;
+
+    // Initialize source data - using RGBA16F format (Float16 per channel)
+    Texture->Source.Init(Width, Height, 1, 1, TSF_RGBA16F);
+    Texture->AddressX = TA_Wrap;
+    Texture->AddressY = TA_Wrap;
+
+    FinishStaticTexture(Texture, Package, Colors);
+    return Texture;
+#else
+    UE_LOG(LogVCET, Error, TEXT("VCET: Static textures can only be created in the editor"));
+    return nullptr;
+#endif
+}
+
+UVolumeTexture* VCET::CreateStaticVolumeTexture(const TArray<FLinearColor>& Colors, int32 Size, const FString& PackagePath, const FString& BaseName, bool bReplaceExisting)
+{
+#if WITH_EDITOR
+    const int32 TotalVoxels = Size * Size * Size;
+    if (Colors.Num() != TotalVoxels)
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCET: Volume data size mismatch! Expected %d, got %d"), TotalVoxels, Colors.Num());
+        return nullptr;
+    }
+
+    UPackage* Package = nullptr;
+    LLM_SCOPE_BYTAG(VCET_AssetSource);
+    UVolumeTexture* Texture = CreateStaticTextureObject<UVolumeTexture>(PackagePath, BaseName, bReplaceExisting, Package);
+    if (!Texture) return nullptr;
+
+    // Initialize source data - using RGBA16F format (Float16 per channel)
+    Texture->Source.Init(Size, Size, Size, 1, TSF_RGBA16F);
+    Texture->AddressMode = TA_Clamp;
+
+    FinishStaticTexture(Texture, Package, Colors);
+    return Texture;
+#else
+    UE_LOG(LogVCET, Error, TEXT("VCET: Static textures can only be created in the editor"));
+    return nullptr;
+#endif
+}
@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+class UTexture2D;
+class UVolumeTexture;
+class UTextureRenderTarget2D;
+class UTextureRenderTargetVolume;
+struct FVCETBakeTelemetry;
+
+/**
+ * Output stage shared by the VCET bakers: uploads baked colors to render targets and saves them as static texture assets.
+ * All functions must be called from the game thread, unless noted otherwise.
+ */
+namespace VCET
+{
+    /**
+     * Uploads Width x Height row-major colors to a 2D render target.
+     * Colors are converted to the render target's format: 8-bit (clamped) for RTF_RGBA8, half or full float for HDR targets.
+     * If set, Telemetry gets the conversion time, the uploaded bytes and the memory of the converted pixels.
+     */
+    void WriteColorToRenderTarget(UTextureRenderTarget2D* RT, const TArray<FLinearColor>& Colors, int32 Width, int32 Height, FVCETBakeTelemetry* Telemetry = nullptr);
+
+    /** Uploads Size^3 colors (X fastest, then Y, then Z) to a volume render target, one Z slice at a time */
+    void WriteColorToVolumeRenderTarget(UTextureRenderTargetVolume* RT, const TArray<FLinearColor>& Colors, int32 Size, FVCETBakeTelemetry* Telemetry = nullptr);
+
+    /**
+     * Converts colors to the pixel layout of Format (PF_FloatRGBA, PF_A32B32G32R32F, PF_B8G8R8A8, PF_R16F or PF_G8).
+     * Returns the bytes per pixel, or 0 if the format isn't supported. Thread safe
+     */
+    int32 ConvertColorsToPixelFormat(const TArray<FLinearColor>& Colors, EPixelFormat Format, TArray<uint8>& OutData);
+
+    /** Upload stages of the Write functions above, for already converted data */
+    void UploadToRenderTarget(UTextureRenderTarget2D* RT, const TSharedRef<TArray<uint8>>& Data, int32 BytesPerPixel, int32 Width, int32 Height);
+    void UploadToVolumeRenderTarget(UTextureRenderTargetVolume* RT, const TSharedRef<TArray<uint8>>& Data, int32 BytesPerPixel, int32 Size);
+
+    /** Returns BaseName, or BaseName_001, BaseName_002... if a package with that name already exists under PackagePath */
+    FString GetUniqueAssetName(const FString& PackagePath, const FString& BaseName);
+
+    /**
+     * Creates and saves a static RGBA16F texture asset under PackagePath (e.g. "/Game/VCET/Textures") from baked colors.
+     * The asset is named by GetUniqueAssetName(), or always BaseName with bReplaceExisting, overwriting the previous bake.
+     * Editor only: returns nullptr in cooked builds.
+     */
+    UTexture2D* CreateStaticTexture2D(const TArray<FLinearColor>& Colors, int32 Width, int32 Height, const FString& PackagePath, const FString& BaseName, bool bReplaceExisting = false);
+    UVolumeTexture* CreateStaticVolumeTexture(const TArray<FLinearColor>& Colors, int32 Size, const FString& PackagePath, const FString& BaseName, bool bReplaceExisting = false);
+}
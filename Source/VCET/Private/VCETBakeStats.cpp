@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETBakeStats.h"
+
+UE_TRACE_CHANNEL_DEFINE(VCETBakeChannel);
+
+DEFINE_STAT(STAT_VCETBake_Positions);
+DEFINE_STAT(STAT_VCETBake_Query);
+DEFINE_STAT(STAT_VCETBake_MetadataCopy);
+DEFINE_STAT(STAT_VCETBake_PostProcess);
+DEFINE_STAT(STAT_VCETBake_Conversion);
+DEFINE_STAT(STAT_VCETBake_GameThread);
+DEFINE_STAT(STAT_VCETBake_Upload);
+DEFINE_STAT(STAT_VCETBake_AssetSave);
+
+DEFINE_STAT(STAT_VCETBake_Samples);
+DEFINE_STAT(STAT_VCETBake_BytesUploaded);
+DEFINE_STAT(STAT_VCETBake_BakesInFlight);
+
+LLM_DEFINE_TAG(VCET);
+LLM_DEFINE_TAG(VCET_Positions, TEXT("Positions"), TEXT("VCET"));
+LLM_DEFINE_TAG(VCET_Query, TEXT("Query"), TEXT("VCET"));
+LLM_DEFINE_TAG(VCET_Results, TEXT("Results"), TEXT("VCET"));
+LLM_DEFINE_TAG(VCET_Conversion, TEXT("Conversion"), TEXT("VCET"));
+LLM_DEFINE_TAG(VCET_Cache, TEXT("Cache"), TEXT("VCET"));
+LLM_DEFINE_TAG(VCET_RenderTargets, TEXT("RenderTargets"), TEXT("VCET"));
+LLM_DEFINE_TAG(VCET_AssetSource, TEXT("AssetSource"), TEXT("VCET"));
+
+TRACE_DECLARE_INT_COUNTER(VCETBake_Samples, TEXT("VCET/Bake/Samples"));
+TRACE_DECLARE_MEMORY_COUNTER(VCETBake_BytesUploaded, TEXT("VCET/Bake/BytesUploaded"));
+TRACE_DECLARE_INT_COUNTER(VCETBake_BakesInFlight, TEXT("VCET/Bake/BakesInFlight"));
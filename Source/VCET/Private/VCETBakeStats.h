@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "HAL/LowLevelMemTracker.h"
+
+/**
+ * Instrumentation of the bake pipeline.
+ *
+ * Every phase of a bake has a cycle stat in STATGROUP_VCETBake (stat VCETBake) and a CPU scope on the VCETBake
+ * trace channel, so bakes can be profiled in Unreal Insights next to the frame with -trace=default,VCETBake.
+ * Samples, uploaded bytes and bakes in flight are both stats and trace counters (-trace=counters).
+ *
+ * Allocations are tagged for the Low Level Memory tracker under VCET (-llm, or Memory Insights with -trace=memory):
+ * transient bake buffers (Positions, Query, Results, Conversion) and what the bakers keep (Cache, RenderTargets, AssetSource).
+ */
+DECLARE_STATS_GROUP(TEXT("VCET Bake"), STATGROUP_VCETBake, STATCAT_Advanced);
+
+UE_TRACE_CHANNEL_EXTERN(VCETBakeChannel);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Position Generation"), STAT_VCETBake_Positions, STATGROUP_VCETBake, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Query"), STAT_VCETBake_Query, STATGROUP_VCETBake, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Metadata Copy"), STAT_VCETBake_MetadataCopy, STATGROUP_VCETBake, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Post Processing"), STAT_VCETBake_PostProcess, STATGROUP_VCETBake, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Conversion"), STAT_VCETBake_Conversion, STATGROUP_VCETBake, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Game Thread Handoff"), STAT_VCETBake_GameThread, STATGROUP_VCETBake, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Render Thread Upload"), STAT_VCETBake_Upload, STATGROUP_VCETBake, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Asset Save"), STAT_VCETBake_AssetSave, STATGROUP_VCETBake, );
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Samples"), STAT_VCETBake_Samples, STATGROUP_VCETBake, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Bytes Uploaded"), STAT_VCETBake_BytesUploaded, STATGROUP_VCETBake, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Bakes In Flight"), STAT_VCETBake_BakesInFlight, STATGROUP_VCETBake, );
+
+LLM_DECLARE_TAG(VCET);
+/** Position buffers of the chunks */
+LLM_DECLARE_TAG(VCET_Positions);
+/** Metadata and distance buffers filled by the queries */
+LLM_DECLARE_TAG(VCET_Query);
+/** Colors and values of the bakes in flight */
+LLM_DECLARE_TAG(VCET_Results);
+/** Pixels converted to the render target format, until uploaded */
+LLM_DECLARE_TAG(VCET_Conversion);
+/** Colors the bakers keep for their static assets, and the baked procedural noise tiles */
+LLM_DECLARE_TAG(VCET_Cache);
+LLM_DECLARE_TAG(VCET_RenderTargets);
+/** Source data of the static texture assets */
+LLM_DECLARE_TAG(VCET_AssetSource);
+
+TRACE_DECLARE_INT_COUNTER_EXTERN(VCETBake_Samples);
+TRACE_DECLARE_MEMORY_COUNTER_EXTERN(VCETBake_BytesUploaded);
+TRACE_DECLARE_INT_COUNTER_EXTERN(VCETBake_BakesInFlight);
+
+// Cycle stat and trace scope of one bake phase. Name is the suffix of one of the STAT_VCETBake_ cycle stats above
+#define VCET_BAKE_SCOPE(Name) \
+    SCOPE_CYCLE_COUNTER(STAT_VCETBake_ ## Name); \
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("VCETBake " #Name, VCETBakeChannel)
+
+namespace VCET
+{
+    FORCEINLINE void AddBakeSamples(int32 Num)
+    {
+        INC_DWORD_STAT_BY(STAT_VCETBake_Samples, Num);
+        TRACE_COUNTER_ADD(VCETBake_Samples, Num);
+    }
+
+    FORCEINLINE void AddBakeBytesUploaded(int64 Num)
+    {
+        INC_MEMORY_STAT_BY(STAT_VCETBake_BytesUploaded, Num);
+        TRACE_COUNTER_ADD(VCETBake_BytesUploaded, Num);
+    }
+
+    // Around the async part of a bake, from its launch to its colors being ready for the game thread
+    FORCEINLINE void BeginBakeInFlight()
+    {
+        INC_DWORD_STAT(STAT_VCETBake_BakesInFlight);
+        TRACE_COUNTER_INCREMENT(VCETBake_BakesInFlight);
+    }
+    FORCEINLINE void EndBakeInFlight()
+    {
+        DEC_DWORD_STAT(STAT_VCETBake_BakesInFlight);
+        TRACE_COUNTER_DECREMENT(VCETBake_BakesInFlight);
+    }
+}
@@ -0,0 +1,154 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETBakeTelemetry.h"
+#include "VCETModule.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+int32 GVCETBakeTelemetryHistorySize = 32;
+static FAutoConsoleVariableRef CVarVCETBakeTelemetryHistorySize(
+    TEXT("vcet.Bake.Telemetry.HistorySize"),
+    GVCETBakeTelemetryHistorySize,
+    TEXT("Number of bake telemetry records kept per baker component."));
+
+int32 GVCETBakeTelemetryWorldHistorySize = 1024;
+static FAutoConsoleVariableRef CVarVCETBakeTelemetryWorldHistorySize(
+    TEXT("vcet.Bake.Telemetry.WorldHistorySize"),
+    GVCETBakeTelemetryWorldHistorySize,
+    TEXT("Number of bake telemetry records kept per world, for all its bakers."));
+
+FString GVCETBakeTelemetryCsv;
+static FAutoConsoleVariableRef CVarVCETBakeTelemetryCsv(
+    TEXT("vcet.Bake.Telemetry.Csv"),
+    GVCETBakeTelemetryCsv,
+    TEXT("If set, every bake telemetry record is appended to this CSV file. Relative paths are relative to the Saved directory."));
+
+namespace VCET
+{
+    void AddBoundedBakeTelemetry(TArray<FVCETBakeTelemetry>& History, const FVCETBakeTelemetry& Record, int32 MaxNum)
+    {
+        MaxNum = FMath::Max(MaxNum, 1);
+        if (History.Num() >= MaxNum)
+        {
+            History.RemoveAt(0, History.Num() - MaxNum + 1, EAllowShrinking::No);
+        }
+        History.Add(Record);
+    }
+
+    // Nearest rank percentiles of one field of the records
+    FVCETBakePercentiles ComputeBakePercentiles(TConstArrayView<FVCETBakeTelemetry> Records, float FVCETBakeTelemetry::* Field)
+    {
+        FVCETBakePercentiles Percentiles;
+        if (Records.Num() == 0)
+        {
+            return Percentiles;
+        }
+
+        TArray<float> Values;
+        Values.Reserve(Records.Num());
+        for (const FVCETBakeTelemetry& Record : Records)
+        {
+            Values.Add(Record.*Field);
+        }
+        Values.Sort();
+
+        const auto GetPercentile = [&](const double Percentile)
+        {
+            const int32 Rank = FMath::CeilToInt32(Percentile * Values.Num());
+            return Values[FMath::Clamp(Rank - 1, 0, Values.Num() - 1)];
+        };
+
+        Percentiles.P50 = GetPercentile(0.5);
+        Percentiles.P90 = GetPercentile(0.9);
+        Percentiles.P99 = GetPercentile(0.99);
+        Percentiles.Max = Values.Last();
+        return Percentiles;
+    }
+
+    FString EscapeCsvField(const FString& Field)
+    {
+        return TEXT("\"") + Field.Replace(TEXT("\""), TEXT("\"\"")) + TEXT("\"");
+    }
+
+    void AppendBakeTelemetryCsv(const FVCETBakeTelemetry& Record)
+    {
+        if (GVCETBakeTelemetryCsv.IsEmpty())
+        {
+            return;
+        }
+
+        const FString Path = FPaths::IsRelative(GVCETBakeTelemetryCsv)
+            ? FPaths::ProjectSavedDir() / GVCETBakeTelemetryCsv
+            : GVCETBakeTelemetryCsv;
+
+        FString Csv;
+        if (!IFileManager::Get().FileExists(*Path))
+        {
+            Csv += TEXT("Timestamp,Baker,Output,QueueWaitMs,PositionsMs,QueryMs,MetadataCopyMs,PostProcessMs,ConversionMs,GameThreadMs,TotalMs,NumSamples,NumSkippedSamples,BytesUploaded,PeakMemoryBytes,QueryLOD,NumCoalescedBakes\n");
+        }
+
+        Csv += FString::Printf(TEXT("%s,%s,%s,%f,%f,%f,%f,%f,%f,%f,%f,%lld,%lld,%lld,%lld,%d,%d\n"),
+            *Record.Timestamp.ToIso8601(),
+            *EscapeCsvField(Record.Baker),
+            *EscapeCsvField(Record.Output),
+            Record.QueueWaitMs,
+            Record.PositionsMs,
+            Record.QueryMs,
+            Record.MetadataCopyMs,
+            Record.PostProcessMs,
+            Record.ConversionMs,
+            Record.GameThreadMs,
+            Record.TotalMs,
+            Record.NumSamples,
+            Record.NumSkippedSamples,
+            Record.BytesUploaded,
+            Record.PeakMemoryBytes,
+            Record.QueryLOD,
+            Record.NumCoalescedBakes);
+
+        if (!FFileHelper::SaveStringToFile(Csv, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append))
+        {
+            UE_LOG(LogVCET, Warning, TEXT("VCET: Failed to append bake telemetry to %s"), *Path);
+        }
+    }
+}
+
+FVCETBakeTelemetrySummary FVCETBakeTelemetrySummary::Compute(TConstArrayView<FVCETBakeTelemetry> Records)
+{
+    FVCETBakeTelemetrySummary Summary;
+    Summary.NumBakes = Records.Num();
+    Summary.TotalMs = VCET::ComputeBakePercentiles(Records, &FVCETBakeTelemetry::TotalMs);
+    Summary.QueueWaitMs = VCET::ComputeBakePercentiles(Records, &FVCETBakeTelemetry::QueueWaitMs);
+    Summary.QueryMs = VCET::ComputeBakePercentiles(Records, &FVCETBakeTelemetry::QueryMs);
+    Summary.GameThreadMs = VCET::ComputeBakePercentiles(Records, &FVCETBakeTelemetry::GameThreadMs);
+
+    int64 NumSamples = 0;
+    double TotalSeconds = 0.;
+    for (const FVCETBakeTelemetry& Record : Records)
+    {
+        NumSamples += Record.NumSamples;
+        TotalSeconds += Record.TotalMs / 1000.;
+        Summary.NumSkippedSamples += Record.NumSkippedSamples;
+        Summary.BytesUploaded += Record.BytesUploaded;
+        Summary.PeakMemoryBytes = FMath::Max(Summary.PeakMemoryBytes, Record.PeakMemoryBytes);
+    }
+    Summary.SamplesPerSecond = TotalSeconds > 0. ? float(NumSamples / TotalSeconds) : 0.f;
+    return Summary;
+}
+
+void UVCETBakeTelemetrySubsystem::RecordBake(const FVCETBakeTelemetry& Telemetry)
+{
+    VCET::AddBoundedBakeTelemetry(History, Telemetry, GVCETBakeTelemetryWorldHistorySize);
+    VCET::AppendBakeTelemetryCsv(Telemetry);
+}
+
+FVCETBakeTelemetrySummary UVCETBakeTelemetrySubsystem::GetBakeSummary() const
+{
+    return FVCETBakeTelemetrySummary::Compute(History);
+}
+
+void UVCETBakeTelemetrySubsystem::ClearBakeHistory()
+{
+    History.Reset();
+}
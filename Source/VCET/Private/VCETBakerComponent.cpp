@@ -0,0 +1,199 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETBakerComponent.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+#include "Engine/TextureRenderTarget.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectHash.h"
+#include "VCETBakeMemory.h"
+#include "VCETBakeStats.h"
+#include "VCETModule.h"
+
+extern int32 GVCETBakeTelemetryHistorySize;
+
+FString UVCETBakerComponent::GetBakerName() const
+{
+    const AActor* Owner = GetOwner();
+    if (!Owner)
+    {
+        return GetName();
+    }
+
+#if WITH_EDITOR
+    return Owner->GetActorLabel() + TEXT(".") + GetName();
+#else
+    return Owner->GetName() + TEXT(".") + GetName();
+#endif
+}
+
+FVCETBakeTelemetrySummary UVCETBakerComponent::GetBakeTelemetrySummary() const
+{
+    return FVCETBakeTelemetrySummary::Compute(TelemetryHistory);
+}
+
+void UVCETBakerComponent::RecordBakeTelemetry(FVCETBakeTelemetry Telemetry, const FString& Output)
+{
+    const double Now = FPlatformTime::Seconds();
+
+    Telemetry.Baker = GetBakerName();
+    Telemetry.Output = Output;
+    Telemetry.Timestamp = FDateTime::UtcNow();
+    Telemetry.GameThreadMs = float((Now - Telemetry.AsyncEndTime) * 1000.);
+    Telemetry.TotalMs = float((Now - Telemetry.LaunchTime) * 1000.);
+
+    VCET::AddBoundedBakeTelemetry(TelemetryHistory, Telemetry, GVCETBakeTelemetryHistorySize);
+
+    if (UWorld* World = GetWorld())
+    {
+        if (UVCETBakeTelemetrySubsystem* Subsystem = World->GetSubsystem<UVCETBakeTelemetrySubsystem>())
+        {
+            Subsystem->RecordBake(Telemetry);
+        }
+    }
+}
+
+int64 UVCETBakerComponent::GetCachedColorsBytes() const
+{
+    int64 Bytes = 0;
+    for (const TPair<FName, FVCETBakeCache>& It : CachedColors)
+    {
+        Bytes += It.Value.Colors.GetAllocatedSize();
+    }
+    return Bytes;
+}
+
+int64 UVCETBakerComponent::GetRenderTargetBytes() const
+{
+    TArray<UObject*> Objects;
+    GetObjectsWithOuter(this, Objects, false);
+
+    int64 Bytes = 0;
+    for (const UObject* Object : Objects)
+    {
+        if (const UTextureRenderTarget* RenderTarget = Cast<UTextureRenderTarget>(Object))
+        {
+            Bytes += RenderTarget->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+        }
+    }
+    return Bytes;
+}
+
+void UVCETBakerComponent::OnRegister()
+{
+    Super::OnRegister();
+
+    if (!IsTemplate())
+    {
+        VCET::FBakeMemoryBudget::Get().RegisterBaker(this);
+    }
+}
+
+void UVCETBakerComponent::OnUnregister()
+{
+    if (!IsTemplate())
+    {
+        VCET::FBakeMemoryBudget::Get().UnregisterBaker(this);
+    }
+
+    Super::OnUnregister();
+}
+
+void UVCETBakerComponent::BeginDestroy()
+{
+    for (const TPair<FName, FVCETBakeCache>& It : CachedColors)
+    {
+        if (!It.Value.SpillPath.IsEmpty())
+        {
+            IFileManager::Get().Delete(*It.Value.SpillPath, false, false, true);
+        }
+    }
+    CachedColors.Empty();
+
+    Super::BeginDestroy();
+}
+
+void UVCETBakerComponent::SetCachedColors(FName Output, const TArray<FLinearColor>& Colors, const FIntVector& Size)
+{
+    LLM_SCOPE_BYTAG(VCET_Cache);
+
+    FVCETBakeCache& Cache = CachedColors.FindOrAdd(Output);
+    if (!Cache.SpillPath.IsEmpty())
+    {
+        IFileManager::Get().Delete(*Cache.SpillPath, false, false, true);
+        Cache.SpillPath.Reset();
+    }
+
+    Cache.Colors = Colors;
+    Cache.Size = Size;
+    Cache.LastUseTime = FPlatformTime::Seconds();
+}
+
+const FVCETBakeCache* UVCETBakerComponent::FindCachedColors(FName Output)
+{
+    FVCETBakeCache* Cache = CachedColors.Find(Output);
+    if (!Cache)
+    {
+        return nullptr;
+    }
+
+    if (!Cache->SpillPath.IsEmpty())
+    {
+        LLM_SCOPE_BYTAG(VCET_Cache);
+
+        // The reloaded colors are resident again: make room for them like for a bake. The cache itself is spilled, so it can't be evicted here
+        const int64 ExpectedSize = int64(Cache->Size.X) * Cache->Size.Y * Cache->Size.Z * sizeof(FLinearColor);
+        VCET::FBakeMemoryBudget::Get().ReserveCache(ExpectedSize);
+
+        TArray<uint8> Data;
+        if (FFileHelper::LoadFileToArray(Data, *Cache->SpillPath) && Data.Num() == ExpectedSize)
+        {
+            Cache->Colors.SetNumUninitialized(Data.Num() / sizeof(FLinearColor));
+            FMemory::Memcpy(Cache->Colors.GetData(), Data.GetData(), Data.Num());
+        }
+        else
+        {
+            UE_LOG(LogVCET, Error, TEXT("VCET: Failed to reload the spilled colors of %s.%s from %s"), *GetBakerName(), *Output.ToString(), *Cache->SpillPath);
+        }
+
+        IFileManager::Get().Delete(*Cache->SpillPath, false, false, true);
+        Cache->SpillPath.Reset();
+    }
+
+    if (Cache->Colors.Num() == 0)
+    {
+        return nullptr;
+    }
+
+    Cache->LastUseTime = FPlatformTime::Seconds();
+    return Cache;
+}
+
+int64 UVCETBakerComponent::EvictCachedColors(FName Output, bool bSpill)
+{
+    FVCETBakeCache* Cache = CachedColors.Find(Output);
+    if (!Cache || Cache->Colors.Num() == 0)
+    {
+        return 0;
+    }
+
+    if (bSpill)
+    {
+        const FString Path = FPaths::ProjectSavedDir() / TEXT("VCET/Cache") / FGuid::NewGuid().ToString() + TEXT(".bin");
+        const TArrayView64<const uint8> Data(reinterpret_cast<const uint8*>(Cache->Colors.GetData()), Cache->Colors.Num() * int64(sizeof(FLinearColor)));
+        if (FFileHelper::SaveArrayToFile(Data, *Path))
+        {
+            Cache->SpillPath = Path;
+        }
+        else
+        {
+            UE_LOG(LogVCET, Warning, TEXT("VCET: Failed to spill the cached colors of %s.%s to %s, dropping them"), *GetBakerName(), *Output.ToString(), *Path);
+        }
+    }
+
+    const int64 Bytes = Cache->Colors.GetAllocatedSize();
+    Cache->Colors.Empty();
+    return Bytes;
+}
@@ -4,6 +4,8 @@
 
 #define LOCTEXT_NAMESPACE "FVCETModule"
 
+DEFINE_LOG_CATEGORY(LogVCET);
+
 void FVCETModule::StartupModule()
 {
 }
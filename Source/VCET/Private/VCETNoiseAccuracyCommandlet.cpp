@@ -0,0 +1,254 @@
+// Copyright Zundle. MIT License.
+
+#include "VCETNoiseAccuracyCommandlet.h"
+#include "VCETProceduralNoiseKernel.h"
+#include "VCETModule.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Math/RandomStream.h"
+#include <cmath>
+
+namespace VCETNoiseAccuracy
+{
+    struct FError
+    {
+        FString Name;
+        double MaxError = 0.;
+        double MeanError = 0.;
+        double MaxAllowedError = 0.;
+    };
+
+    // Default bounds of the fast math primitives, a few times their measured max error over the ranges below.
+    // Pow compounds the log2 and exp2 errors, scaled by the exponent
+    constexpr double MaxSinCosError = 1.e-3;
+    constexpr double MaxExpError = 5.e-4;
+    constexpr double MaxLog2Error = 5.e-4;
+    constexpr double MaxPowError = 5.e-3;
+
+    FError MeasurePrimitive(
+        const TCHAR* Name,
+        const ispc::EProceduralFastMathFunction Function,
+        const TArray<float>& A,
+        const TArray<float>& B,
+        TFunctionRef<double(double, double)> Reference,
+        const bool bRelative,
+        const double MaxAllowedError)
+    {
+        TArray<float> Fast;
+        Fast.SetNumUninitialized(A.Num());
+        ispc::ProceduralNoise_EvaluateFastMath(Function, A.GetData(), B.GetData(), Fast.GetData(), A.Num());
+
+        FError Error;
+        Error.Name = Name;
+        Error.MaxAllowedError = MaxAllowedError;
+
+        for (int32 Index = 0; Index < A.Num(); Index++)
+        {
+            const double Expected = Reference(A[Index], B[Index]);
+            double Delta = FMath::Abs(double(Fast[Index]) - Expected);
+            if (bRelative)
+            {
+                // Relative error is meaningless close to underflow, which the noises treat as 0 anyway
+                Delta /= FMath::Max(FMath::Abs(Expected), 1.e-6);
+            }
+
+            Error.MaxError = FMath::Max(Error.MaxError, Delta);
+            Error.MeanError += Delta;
+        }
+        Error.MeanError /= FMath::Max(A.Num(), 1);
+        return Error;
+    }
+
+    template<int32 Dimension, typename EnumType>
+    FError MeasureNoise(const EnumType Type, const int32 NumOctaves, const TArray<float>(&Positions)[3])
+    {
+        using FArgs = TVCETProceduralNoiseArgs<Dimension>;
+
+        const int32 Num = Positions[0].Num();
+        const float Amplitude = 1.f;
+        const float FeatureScale = 10000.f;
+        const float Lacunarity = 2.f;
+        const float Gain = 0.5f;
+        const float VoronoiSmoothness = 0.5f;
+        const float WaveletPhase = 0.f;
+        const float ScratchSmoothness = 0.05f;
+
+        TArray<typename FArgs::FOctave> Octaves;
+        for (int32 Index = 0; Index < NumOctaves; Index++)
+        {
+            typename FArgs::FOctave& Octave = Octaves.Emplace_GetRef();
+            FMemory::Memzero(Octave);
+            Octave.Type = GetISPCNoise(Type);
+            Octave.bStrengthIsConstant = true;
+            Octave.StrengthConstant = 1.f;
+        }
+
+        FArgs Args;
+        for (int32 Axis = 0; Axis < Dimension; Axis++)
+        {
+            Args.Position[Axis] = FVCETNoiseStream(Positions[Axis].GetData(), false);
+        }
+        Args.Amplitude = FVCETNoiseStream(&Amplitude, true);
+        Args.FeatureScale = FVCETNoiseStream(&FeatureScale, true);
+        Args.Lacunarity = FVCETNoiseStream(&Lacunarity, true);
+        Args.Gain = FVCETNoiseStream(&Gain, true);
+        Args.VoronoiSmoothness = FVCETNoiseStream(&VoronoiSmoothness, true);
+        Args.WaveletPhase = FVCETNoiseStream(&WaveletPhase, true);
+        Args.ScratchSmoothness = FVCETNoiseStream(&ScratchSmoothness, true);
+        Args.Octaves = Octaves;
+        Args.Seed = 1337;
+
+        TArray<float> Exact;
+        TArray<float> Fast;
+        Exact.SetNumUninitialized(Num);
+        Fast.SetNumUninitialized(Num);
+
+        Args.bFastMath = false;
+        VCET::EvaluateProceduralNoise(Args, Exact.GetData(), 0, Num);
+
+        Args.bFastMath = true;
+        VCET::EvaluateProceduralNoise(Args, Fast.GetData(), 0, Num);
+
+        FError Error;
+        Error.Name = FString::Printf(TEXT("%dD %s"), Dimension, *StaticEnum<EnumType>()->GetNameStringByValue(int64(Type)));
+
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            const double Delta = FMath::Abs(double(Fast[Index]) - double(Exact[Index]));
+            Error.MaxError = FMath::Max(Error.MaxError, Delta);
+            Error.MeanError += Delta;
+        }
+        Error.MeanError /= FMath::Max(Num, 1);
+        return Error;
+    }
+}
+
+UVCETNoiseAccuracyCommandlet::UVCETNoiseAccuracyCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UVCETNoiseAccuracyCommandlet::Main(const FString& Params)
+{
+    using namespace VCETNoiseAccuracy;
+
+    double MaxAllowedError = VCET::ProceduralNoiseFastMathMaxError;
+    double MaxPrimitiveError = -1.;
+    int32 NumOctaves = 4;
+    int32 Num = 65536;
+    FParse::Value(*Params, TEXT("MaxError="), MaxAllowedError);
+    FParse::Value(*Params, TEXT("MaxPrimitiveError="), MaxPrimitiveError);
+    FParse::Value(*Params, TEXT("Octaves="), NumOctaves);
+    FParse::Value(*Params, TEXT("Num="), Num);
+    NumOctaves = FMath::Clamp(NumOctaves, 1, 255);
+    Num = FMath::Max(Num, 1);
+
+    // -MaxPrimitiveError overrides the bound of every primitive
+    const auto GetPrimitiveBound = [&](const double DefaultBound) { return MaxPrimitiveError >= 0. ? MaxPrimitiveError : DefaultBound; };
+
+    TArray<FError> PrimitiveErrors;
+    {
+        FRandomStream Stream(0x5EED);
+
+        TArray<float> Angles;
+        TArray<float> ExpArguments;
+        TArray<float> Log2Arguments;
+        TArray<float> PowBases;
+        TArray<float> PowExponents;
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            // Scratch and Wavelet feed hashed angles of up to a few thousand radians to sin/cos
+            Angles.Add(Stream.FRandRange(-4096.f, 4096.f));
+            // Crater and Erosion only use exp of negative distances
+            ExpArguments.Add(Stream.FRandRange(-40.f, 0.f));
+            // Pow takes the log2 of its positive bases
+            Log2Arguments.Add(FMath::Pow(10.f, Stream.FRandRange(-12.f, 4.f)));
+            // Voronoi raises [0, 1] weights to 1 / Smoothness, Erosion raises slopes to -0.25
+            if (Index % 2 == 0)
+            {
+                PowBases.Add(Stream.FRandRange(0.f, 1.f));
+                PowExponents.Add(1.f / Stream.FRandRange(0.05f, 1.f));
+            }
+            else
+            {
+                PowBases.Add(FMath::Pow(10.f, Stream.FRandRange(-12.f, 4.f)));
+                PowExponents.Add(-0.25f);
+            }
+        }
+
+        PrimitiveErrors.Add(MeasurePrimitive(TEXT("sin (absolute)"), ispc::ProceduralFastMath_Sin, Angles, Angles, [](const double A, double) { return std::sin(A); }, false, GetPrimitiveBound(MaxSinCosError)));
+        PrimitiveErrors.Add(MeasurePrimitive(TEXT("cos (absolute)"), ispc::ProceduralFastMath_Cos, Angles, Angles, [](const double A, double) { return std::cos(A); }, false, GetPrimitiveBound(MaxSinCosError)));
+        PrimitiveErrors.Add(MeasurePrimitive(TEXT("exp (relative)"), ispc::ProceduralFastMath_Exp, ExpArguments, ExpArguments, [](const double A, double) { return std::exp(A); }, true, GetPrimitiveBound(MaxExpError)));
+        PrimitiveErrors.Add(MeasurePrimitive(TEXT("log2 (absolute)"), ispc::ProceduralFastMath_Log2, Log2Arguments, Log2Arguments, [](const double A, double) { return std::log2(A); }, false, GetPrimitiveBound(MaxLog2Error)));
+        PrimitiveErrors.Add(MeasurePrimitive(TEXT("pow (relative)"), ispc::ProceduralFastMath_Pow, PowBases, PowExponents, [](const double A, const double B) { return std::pow(A, B); }, true, GetPrimitiveBound(MaxPowError)));
+    }
+
+    TArray<FError> NoiseErrors;
+    {
+        FRandomStream Stream(0x5EED);
+
+        TArray<float> Positions[3];
+        for (TArray<float>& Axis : Positions)
+        {
+            Axis.SetNumUninitialized(Num);
+            for (float& Value : Axis)
+            {
+                Value = Stream.FRandRange(-1000000.f, 1000000.f);
+            }
+        }
+
+        for (int32 TypeIndex = 0; TypeIndex <= int32(EVoxelProceduralNoiseType2D::InterleavedGradient); TypeIndex++)
+        {
+            NoiseErrors.Add(MeasureNoise<2>(EVoxelProceduralNoiseType2D(TypeIndex), NumOctaves, Positions));
+        }
+        for (int32 TypeIndex = 0; TypeIndex <= int32(EVoxelProceduralNoiseType3D::InterleavedGradient); TypeIndex++)
+        {
+            NoiseErrors.Add(MeasureNoise<3>(EVoxelProceduralNoiseType3D(TypeIndex), NumOctaves, Positions));
+        }
+        for (FError& Error : NoiseErrors)
+        {
+            Error.MaxAllowedError = MaxAllowedError;
+        }
+    }
+
+    FString Csv = TEXT("Kind,Name,MaxError,MeanError,MaxAllowedError\n");
+    bool bFailed = false;
+
+    const auto Report = [&](const TCHAR* Kind, const FError& Error)
+    {
+        const bool bExceeded = Error.MaxError > Error.MaxAllowedError;
+        bFailed |= bExceeded;
+
+        if (bExceeded)
+        {
+            UE_LOG(LogVCET, Error, TEXT("VCETNoiseAccuracy: %-24s max %.3e mean %.3e exceeds %.3e"), *Error.Name, Error.MaxError, Error.MeanError, Error.MaxAllowedError);
+        }
+        else
+        {
+            UE_LOG(LogVCET, Display, TEXT("VCETNoiseAccuracy: %-24s max %.3e mean %.3e"), *Error.Name, Error.MaxError, Error.MeanError);
+        }
+        Csv += FString::Printf(TEXT("%s,%s,%e,%e,%e\n"), Kind, *Error.Name, Error.MaxError, Error.MeanError, Error.MaxAllowedError);
+    };
+
+    for (const FError& Error : PrimitiveErrors)
+    {
+        Report(TEXT("Primitive"), Error);
+    }
+    for (const FError& Error : NoiseErrors)
+    {
+        Report(TEXT("Noise"), Error);
+    }
+
+    FString OutputPath;
+    if (FParse::Value(*Params, TEXT("Output="), OutputPath) &&
+        !FFileHelper::SaveStringToFile(Csv, *OutputPath))
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCETNoiseAccuracy: Failed to write %s"), *OutputPath);
+        return 1;
+    }
+
+    return bFailed ? 1 : 0;
+}
@@ -0,0 +1,312 @@
+// Copyright Zundle. MIT License.
+
+#include "VCETNoiseBenchmarkCommandlet.h"
+#include "VCETProceduralNoiseKernel.h"
+#include "VCETModule.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Math/RandomStream.h"
+
+namespace VCETNoiseBenchmark
+{
+    TArray<int32> ParseIntList(const FString& Params, const TCHAR* Key, const TArray<int32>& Default)
+    {
+        FString Value;
+        if (!FParse::Value(*Params, Key, Value, false))
+        {
+            return Default;
+        }
+
+        TArray<FString> Parts;
+        Value.ParseIntoArray(Parts, TEXT(","));
+
+        TArray<int32> Result;
+        for (const FString& Part : Parts)
+        {
+            const int32 Int = FCString::Atoi(*Part);
+            if (Int > 0)
+            {
+                Result.Add(Int);
+            }
+        }
+        return Result.Num() > 0 ? Result : Default;
+    }
+
+    TArray<FString> ParseStringList(const FString& Params, const TCHAR* Key)
+    {
+        FString Value;
+        TArray<FString> Result;
+        if (FParse::Value(*Params, Key, Value, false))
+        {
+            Value.ParseIntoArray(Result, TEXT(","));
+        }
+        return Result;
+    }
+
+    struct FPositions
+    {
+        TArray<float> X;
+        TArray<float> Y;
+        TArray<float> Z;
+    };
+
+    // Deterministic scattered positions: same set on every run and every machine
+    FPositions MakePositions(const int32 Num)
+    {
+        FRandomStream Stream(0x5EED);
+
+        FPositions Positions;
+        Positions.X.SetNumUninitialized(Num);
+        Positions.Y.SetNumUninitialized(Num);
+        Positions.Z.SetNumUninitialized(Num);
+
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            Positions.X[Index] = Stream.FRandRange(-1000000.f, 1000000.f);
+            Positions.Y[Index] = Stream.FRandRange(-1000000.f, 1000000.f);
+            Positions.Z[Index] = Stream.FRandRange(-1000000.f, 1000000.f);
+        }
+        return Positions;
+    }
+
+    struct FRow
+    {
+        int32 Dimension = 0;
+        FString Type;
+        int32 NumOctaves = 0;
+        int32 NumSamples = 0;
+        bool bFastMath = false;
+        int32 Iterations = 0;
+        double Seconds = 0.;
+
+        double GetNsPerSample() const
+        {
+            return Seconds * 1.e9 / (double(NumSamples) * Iterations);
+        }
+        double GetSamplesPerSecond() const
+        {
+            return double(NumSamples) * Iterations / Seconds;
+        }
+    };
+
+    template<int32 Dimension, typename EnumType, typename LambdaType>
+    FRow Run(
+        const EnumType Type,
+        const int32 NumOctaves,
+        const FPositions& Positions,
+        const int32 NumSamples,
+        const double MinTime,
+        const bool bFastMath,
+        LambdaType&& Evaluate)
+    {
+        using FArgs = TVCETProceduralNoiseArgs<Dimension>;
+
+        // Node defaults
+        const float Amplitude = 10000.f;
+        const float FeatureScale = 100000.f;
+        const float Lacunarity = 2.f;
+        const float Gain = 0.5f;
+        const float VoronoiSmoothness = 1.f;
+        const float WaveletPhase = 0.f;
+        const float ScratchSmoothness = 0.05f;
+
+        TArray<typename FArgs::FOctave> Octaves;
+        for (int32 Index = 0; Index < NumOctaves; Index++)
+        {
+            typename FArgs::FOctave& Octave = Octaves.Emplace_GetRef();
+            FMemory::Memzero(Octave);
+            Octave.Type = GetISPCNoise(Type);
+            Octave.bStrengthIsConstant = true;
+            Octave.StrengthConstant = 1.f;
+        }
+
+        FArgs Args;
+        Args.Position[0] = FVCETNoiseStream(Positions.X.GetData(), false);
+        Args.Position[1] = FVCETNoiseStream(Positions.Y.GetData(), false);
+        if constexpr (Dimension == 3)
+        {
+            Args.Position[2] = FVCETNoiseStream(Positions.Z.GetData(), false);
+        }
+        Args.Amplitude = FVCETNoiseStream(&Amplitude, true);
+        Args.FeatureScale = FVCETNoiseStream(&FeatureScale, true);
+        Args.Lacunarity = FVCETNoiseStream(&Lacunarity, true);
+        Args.Gain = FVCETNoiseStream(&Gain, true);
+        Args.VoronoiSmoothness = FVCETNoiseStream(&VoronoiSmoothness, true);
+        Args.WaveletPhase = FVCETNoiseStream(&WaveletPhase, true);
+        Args.ScratchSmoothness = FVCETNoiseStream(&ScratchSmoothness, true);
+        Args.Octaves = Octaves;
+        Args.Seed = 1337;
+        Args.bFastMath = bFastMath;
+
+        TArray<float> Output;
+        Output.SetNumUninitialized(NumSamples);
+
+        // Warm up caches and lazily initialized data
+        Evaluate(Args, Output.GetData(), NumSamples);
+
+        FRow Row;
+        Row.Dimension = Dimension;
+        Row.Type = StaticEnum<EnumType>()->GetNameStringByValue(int64(Type));
+        Row.NumOctaves = NumOctaves;
+        Row.NumSamples = NumSamples;
+        Row.bFastMath = bFastMath;
+
+        const double StartTime = FPlatformTime::Seconds();
+        do
+        {
+            Evaluate(Args, Output.GetData(), NumSamples);
+            Row.Iterations++;
+            Row.Seconds = FPlatformTime::Seconds() - StartTime;
+        }
+        while (Row.Seconds < MinTime);
+
+        return Row;
+    }
+}
+
+UVCETNoiseBenchmarkCommandlet::UVCETNoiseBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UVCETNoiseBenchmarkCommandlet::Main(const FString& Params)
+{
+    using namespace VCETNoiseBenchmark;
+
+    const TArray<int32> Dimensions = ParseIntList(Params, TEXT("Dimensions="), { 2, 3 });
+    const TArray<int32> OctaveCounts = ParseIntList(Params, TEXT("Octaves="), { 1, 4, 10 });
+    const TArray<int32> Sizes = ParseIntList(Params, TEXT("Sizes="), { 1024, 32768, 262144 });
+    const TArray<FString> TypeFilter = ParseStringList(Params, TEXT("Types="));
+
+    double MinTime = 0.25;
+    FParse::Value(*Params, TEXT("MinTime="), MinTime);
+    MinTime = FMath::Max(MinTime, 0.);
+
+    const bool bFastMath = FParse::Param(*Params, TEXT("FastMath"));
+    // Go through the same chunked dispatch as the nodes instead of a single kernel call
+    const bool bParallel = FParse::Param(*Params, TEXT("Parallel"));
+
+    const FString Target = VCET::GetProceduralNoiseISPCTarget();
+    const int32 Width = VCET::GetProceduralNoiseISPCWidth();
+
+    FString OutputPath;
+    if (!FParse::Value(*Params, TEXT("Output="), OutputPath))
+    {
+        OutputPath = FPaths::ProjectSavedDir() / TEXT("VCET") / TEXT("Benchmarks") /
+            FString::Printf(TEXT("NoiseBenchmark-%s-%s.csv"), *Target, *FDateTime::Now().ToString());
+    }
+
+    UE_LOG(LogVCET, Display, TEXT("VCETNoiseBenchmark: ISPC target %s (%d lanes), min time %.2fs per case%s%s"), *Target, Width, MinTime,
+        bFastMath ? TEXT(", fast math") : TEXT(""),
+        bParallel ? TEXT(", parallel") : TEXT(""));
+
+    int32 MaxSize = 0;
+    for (const int32 Size : Sizes)
+    {
+        MaxSize = FMath::Max(MaxSize, Size);
+    }
+    const FPositions Positions = MakePositions(MaxSize);
+
+    const auto IsTypeEnabled = [&](const FString& Name)
+    {
+        if (TypeFilter.Num() == 0)
+        {
+            return true;
+        }
+        return TypeFilter.ContainsByPredicate([&](const FString& Filter) { return Filter.Equals(Name, ESearchCase::IgnoreCase); });
+    };
+
+    TArray<FRow> Rows;
+    for (const int32 Dimension : Dimensions)
+    {
+        for (int32 TypeIndex = 0; TypeIndex <= int32(EVoxelProceduralNoiseType2D::InterleavedGradient); TypeIndex++)
+        {
+            for (const int32 NumOctaves : OctaveCounts)
+            {
+                for (const int32 Size : Sizes)
+                {
+                    FRow Row;
+                    if (Dimension == 2)
+                    {
+                        const EVoxelProceduralNoiseType2D Type = EVoxelProceduralNoiseType2D(TypeIndex);
+                        if (!IsTypeEnabled(StaticEnum<EVoxelProceduralNoiseType2D>()->GetNameStringByValue(TypeIndex)))
+                        {
+                            continue;
+                        }
+
+                        Row = Run<2>(Type, NumOctaves, Positions, Size, MinTime, bFastMath, [&](const FVCETProceduralNoiseArgs2D& Args, float* Output, const int32 Num)
+                        {
+                            if (bParallel)
+                            {
+                                VCET::EvaluateProceduralNoiseParallel(Args, Output, Num);
+                            }
+                            else
+                            {
+                                VCET::EvaluateProceduralNoise(Args, Output, 0, Num);
+                            }
+                        });
+                    }
+                    else if (Dimension == 3)
+                    {
+                        const EVoxelProceduralNoiseType3D Type = EVoxelProceduralNoiseType3D(TypeIndex);
+                        if (!IsTypeEnabled(StaticEnum<EVoxelProceduralNoiseType3D>()->GetNameStringByValue(TypeIndex)))
+                        {
+                            continue;
+                        }
+
+                        Row = Run<3>(Type, NumOctaves, Positions, Size, MinTime, bFastMath, [&](const FVCETProceduralNoiseArgs3D& Args, float* Output, const int32 Num)
+                        {
+                            if (bParallel)
+                            {
+                                VCET::EvaluateProceduralNoiseParallel(Args, Output, Num);
+                            }
+                            else
+                            {
+                                VCET::EvaluateProceduralNoise(Args, Output, 0, Num);
+                            }
+                        });
+                    }
+                    else
+                    {
+                        continue;
+                    }
+
+                    UE_LOG(LogVCET, Display, TEXT("VCETNoiseBenchmark: %dD %-20s Octaves=%-3d Num=%-8d %8.2f ns/sample %12.0f samples/s"),
+                        Row.Dimension, *Row.Type, Row.NumOctaves, Row.NumSamples, Row.GetNsPerSample(), Row.GetSamplesPerSecond());
+
+                    Rows.Add(Row);
+                }
+            }
+        }
+    }
+
+    FString Csv = TEXT("Dimension,NoiseType,NumOctaves,NumSamples,FastMath,Parallel,ISPCTarget,ISPCWidth,Iterations,Seconds,NsPerSample,SamplesPerSecond\n");
+    for (const FRow& Row : Rows)
+    {
+        Csv += FString::Printf(TEXT("%d,%s,%d,%d,%d,%d,%s,%d,%d,%f,%f,%f\n"),
+            Row.Dimension,
+            *Row.Type,
+            Row.NumOctaves,
+            Row.NumSamples,
+            Row.bFastMath ? 1 : 0,
+            bParallel ? 1 : 0,
+            *Target,
+            Width,
+            Row.Iterations,
+            Row.Seconds,
+            Row.GetNsPerSample(),
+            Row.GetSamplesPerSecond());
+    }
+
+    if (!FFileHelper::SaveStringToFile(Csv, *OutputPath))
+    {
+        UE_LOG(LogVCET, Error, TEXT("VCETNoiseBenchmark: Failed to write %s"), *OutputPath);
+        return 1;
+    }
+
+    UE_LOG(LogVCET, Display, TEXT("VCETNoiseBenchmark: Wrote %d results to %s"), Rows.Num(), *OutputPath);
+    return 0;
+}
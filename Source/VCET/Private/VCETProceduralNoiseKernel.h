@@ -0,0 +1,165 @@
+// Copyright Zundle. MIT License.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+#include "VCETProceduralNoiseNodes.h"
+#include "VCETProceduralNoiseNodesImpl.ispc.generated.h"
+
+FORCEINLINE ispc::EProceduralNoise2D GetISPCNoise(const EVoxelProceduralNoiseType2D Noise)
+{
+	switch (Noise)
+	{
+	default: ensure(false);
+
+#define CASE(Name) case EVoxelProceduralNoiseType2D::Name: return ispc::ProceduralNoise2D_ ## Name;
+
+	case EVoxelProceduralNoiseType2D::Default:
+	CASE(Perlin);
+	CASE(Simplex);
+	CASE(Value);
+	CASE(Worley);
+	CASE(Voronoi);
+	CASE(Blue);
+	CASE(HilbertBlue);
+	CASE(Crater);
+	CASE(Gabor);
+	CASE(Curl);
+	CASE(Scratch);
+	CASE(Wavelet);
+	CASE(Erosion);
+	CASE(Paper);
+	CASE(Stone);
+	CASE(Wool);
+	CASE(InterleavedGradient);
+
+#undef CASE
+	}
+}
+
+FORCEINLINE ispc::EProceduralNoise3D GetISPCNoise(const EVoxelProceduralNoiseType3D Noise)
+{
+	switch (Noise)
+	{
+	default: ensure(false);
+
+#define CASE(Name) case EVoxelProceduralNoiseType3D::Name: return ispc::ProceduralNoise3D_ ## Name;
+
+	case EVoxelProceduralNoiseType3D::Default:
+	CASE(Perlin);
+	CASE(Simplex);
+	CASE(Value);
+	CASE(Worley);
+	CASE(Voronoi);
+	CASE(Blue);
+	CASE(HilbertBlue);
+	CASE(Crater);
+	CASE(Gabor);
+	CASE(Curl);
+	CASE(Scratch);
+	CASE(Wavelet);
+	CASE(Erosion);
+	CASE(Paper);
+	CASE(Stone);
+	CASE(Wool);
+	CASE(InterleavedGradient);
+
+#undef CASE
+	}
+}
+
+FORCEINLINE ispc::EProceduralAccumulation GetISPCAccumulation(const EVoxelProceduralNoiseAccumulation Accumulation)
+{
+	switch (Accumulation)
+	{
+	default: ensure(false);
+	case EVoxelProceduralNoiseAccumulation::FBM: return ispc::ProceduralAccumulation_FBM;
+	case EVoxelProceduralNoiseAccumulation::Ridged: return ispc::ProceduralAccumulation_Ridged;
+	case EVoxelProceduralNoiseAccumulation::Billow: return ispc::ProceduralAccumulation_Billow;
+	case EVoxelProceduralNoiseAccumulation::HybridMultifractal: return ispc::ProceduralAccumulation_HybridMultifractal;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// A float input of the ISPC kernels: either a single constant, or one value per sample
+struct FVCETNoiseStream
+{
+	const float* Data = nullptr;
+	bool bConstant = true;
+
+	FVCETNoiseStream() = default;
+	FVCETNoiseStream(const FVoxelFloatBuffer& Buffer)
+		: Data(Buffer.GetData())
+		, bConstant(Buffer.IsConstant())
+	{
+	}
+	FVCETNoiseStream(const float* Data, const bool bConstant)
+		: Data(Data)
+		, bConstant(bConstant)
+	{
+	}
+
+	FORCEINLINE const float* GetData(const int32 Offset) const
+	{
+		return bConstant ? Data : Data + Offset;
+	}
+};
+
+// Everything the ISPC kernels need besides the output buffer
+// Used by the nodes and by the noise commandlets so that both go through the exact same code path
+template<int32 Dimension>
+struct TVCETProceduralNoiseArgs
+{
+	static_assert(Dimension == 2 || Dimension == 3, "");
+
+	using FOctave = std::conditional_t<Dimension == 2, ispc::FProceduralOctave2D, ispc::FProceduralOctave3D>;
+
+	FVCETNoiseStream Position[Dimension];
+	FVCETNoiseStream Amplitude;
+	FVCETNoiseStream FeatureScale;
+	FVCETNoiseStream Lacunarity;
+	FVCETNoiseStream Gain;
+	FVCETNoiseStream VoronoiSmoothness;
+	FVCETNoiseStream WaveletPhase;
+	FVCETNoiseStream ScratchSmoothness;
+
+	TConstVoxelArrayView<FOctave> Octaves;
+	ispc::EProceduralAccumulation Accumulation = ispc::ProceduralAccumulation_FBM;
+	int32 Seed = 0;
+	bool bFastMath = false;
+};
+using FVCETProceduralNoiseArgs2D = TVCETProceduralNoiseArgs<2>;
+using FVCETProceduralNoiseArgs3D = TVCETProceduralNoiseArgs<3>;
+
+namespace VCET
+{
+	// Max deviation of FastMath noise from the exact kernels at Amplitude = 1, enforced by VCETNoiseAccuracy
+	constexpr double ProceduralNoiseFastMathMaxError = 0.02;
+
+	// Evaluates samples [Start, Start + Num) of Args into ReturnValue[0, Num)
+	void EvaluateProceduralNoise(const FVCETProceduralNoiseArgs2D& Args, float* ReturnValue, int32 Start, int32 Num);
+	void EvaluateProceduralNoise(const FVCETProceduralNoiseArgs3D& Args, float* ReturnValue, int32 Start, int32 Num);
+
+	// Evaluates samples [0, Num) of Args into ReturnValue
+	// Above vcet.Noise.ParallelThreshold, splits the buffer in vcet.Noise.ParallelChunkSize chunks evaluated with ParallelFor
+	template<typename ArgsType>
+	void EvaluateProceduralNoiseParallel(const ArgsType& Args, float* ReturnValue, int32 Num);
+
+	// Evaluates samples [0, Num) of Args into ReturnValue, skipping samples whose Mask is 0 and setting them to 0
+	// Active samples are compacted before calling the kernels, so the cost scales with the number of active samples
+	template<typename ArgsType>
+	void EvaluateProceduralNoiseMasked(const ArgsType& Args, const float* Mask, float* ReturnValue, int32 Num);
+
+	// Evaluates samples [0, Num) of Args into ReturnValue if the positions repeat, either with a period or in runs,
+	// as when feeding the XY of 3D chunk positions to a 2D noise. Each unique position is evaluated once
+	// Returns false, leaving ReturnValue untouched, if the positions don't repeat or any other input varies per sample
+	bool EvaluateProceduralNoiseDeduplicated(const FVCETProceduralNoiseArgs2D& Args, float* ReturnValue, int32 Num);
+
+	// Name of the ISPC target selected at runtime on this machine, eg AVX2
+	FString GetProceduralNoiseISPCTarget();
+	// Number of SIMD lanes of the ISPC target selected at runtime
+	int32 GetProceduralNoiseISPCWidth();
+}
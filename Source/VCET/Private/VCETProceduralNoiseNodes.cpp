@@ -1,71 +1,646 @@
 // Copyright Zundle. MIT License.
 
 #include "VCETProceduralNoiseNodes.h"
-#include "VCETProceduralNoiseNodesImpl.ispc.generated.h"
+#include "VCETProceduralNoiseKernel.h"
+#include "VCETProceduralNoiseStats.h"
 #include "VoxelBufferAccessor.h"
+#include "Async/ParallelFor.h"
+
+static int32 GVCETNoiseParallelThreshold = 65536;
+static FAutoConsoleVariableRef CVarVCETNoiseParallelThreshold(
+	TEXT("vcet.Noise.ParallelThreshold"),
+	GVCETNoiseParallelThreshold,
+	TEXT("Procedural noise buffers with at least this many samples are split into chunks evaluated on worker threads. 0 to disable."));
+
+static int32 GVCETNoiseParallelChunkSize = 8192;
+static FAutoConsoleVariableRef CVarVCETNoiseParallelChunkSize(
+	TEXT("vcet.Noise.ParallelChunkSize"),
+	GVCETNoiseParallelChunkSize,
+	TEXT("Number of samples per chunk when procedural noise is evaluated in parallel, at least 1024 (smaller values are raised to it). Keeps the inputs and output of a chunk in L2."));
+
+static int32 GVCETNoiseDeduplicateXY = 1;
+static FAutoConsoleVariableRef CVarVCETNoiseDeduplicateXY(
+	TEXT("vcet.Noise.DeduplicateXY"),
+	GVCETNoiseDeduplicateXY,
+	TEXT("If true, 2D procedural noise detects positions repeating in columns (eg the XY of 3D chunk queries) and evaluates each unique XY once."));
+
+static int32 GVCETNoiseHilbertBlueTable = 1;
+static FAutoConsoleVariableRef CVarVCETNoiseHilbertBlueTable(
+	TEXT("vcet.Noise.HilbertBlueTable"),
+	GVCETNoiseHilbertBlueTable,
+	TEXT("If true, HilbertBlue noise reads precomputed curve values (1MB per dimension, built on first use) instead of walking the Hilbert curve per sample."));
+
+namespace VCET
+{
+	// The seed only offsets the lookup into the curve, so a single table serves every seed
+	const float* GetHilbertBlueTable2D()
+	{
+		static const TVoxelArray<float> Table = []
+		{
+			VOXEL_SCOPE_COUNTER("Build HilbertBlue 2D table");
+
+			TVoxelArray<float> Result;
+			Result.SetNumUninitialized(512 * 512);
+			ispc::ProceduralNoise_BuildHilbertBlueTable2D(Result.GetData());
+			return Result;
+		}();
+		return Table.GetData();
+	}
+	const float* GetHilbertBlueTable3D()
+	{
+		static const TVoxelArray<float> Table = []
+		{
+			VOXEL_SCOPE_COUNTER("Build HilbertBlue 3D table");
+
+			TVoxelArray<float> Result;
+			Result.SetNumUninitialized(64 * 64 * 64);
+			ispc::ProceduralNoise_BuildHilbertBlueTable3D(Result.GetData());
+			return Result;
+		}();
+		return Table.GetData();
+	}
+
+	template<typename OctaveType, typename NoiseType>
+	FORCEINLINE bool UsesNoise(const TConstVoxelArrayView<OctaveType> Octaves, const NoiseType Noise)
+	{
+		for (const OctaveType& Octave : Octaves)
+		{
+			if (Octave.Type == Noise)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template<typename ArgsType>
+	FORCEINLINE void OffsetOctaves(const ArgsType& Args, const int32 Start, TVoxelInlineArray<typename ArgsType::FOctave, 16>& OutOctaves)
+	{
+		OutOctaves.Append(Args.Octaves.GetData(), Args.Octaves.Num());
+
+		for (typename ArgsType::FOctave& Octave : OutOctaves)
+		{
+			if (!Octave.bStrengthIsConstant)
+			{
+				Octave.StrengthArray += Start;
+			}
+		}
+	}
+}
+
+void VCET::EvaluateProceduralNoise(const FVCETProceduralNoiseArgs2D& Args, float* ReturnValue, const int32 Start, const int32 Num)
+{
+	TVoxelInlineArray<ispc::FProceduralOctave2D, 16> Octaves;
+	OffsetOctaves(Args, Start, Octaves);
+
+	const float* HilbertBlueTable = nullptr;
+	if (GVCETNoiseHilbertBlueTable &&
+		UsesNoise(Args.Octaves, ispc::ProceduralNoise2D_HilbertBlue))
+	{
+		HilbertBlueTable = GetHilbertBlueTable2D();
+	}
+
+	const bool bStats = AreProceduralNoiseStatsEnabled();
+	FProceduralNoiseTypeCycles TypeCycles;
+
+	ispc::VoxelNode_ProceduralNoise2D(
+		Args.Position[0].GetData(Start),
+		Args.Position[0].bConstant,
+		Args.Position[1].GetData(Start),
+		Args.Position[1].bConstant,
+		Args.Amplitude.GetData(Start),
+		Args.Amplitude.bConstant,
+		Args.FeatureScale.GetData(Start),
+		Args.FeatureScale.bConstant,
+		Args.Lacunarity.GetData(Start),
+		Args.Lacunarity.bConstant,
+		Args.Gain.GetData(Start),
+		Args.Gain.bConstant,
+		Args.VoronoiSmoothness.GetData(Start),
+		Args.VoronoiSmoothness.bConstant,
+		Args.WaveletPhase.GetData(Start),
+		Args.WaveletPhase.bConstant,
+		Args.ScratchSmoothness.GetData(Start),
+		Args.ScratchSmoothness.bConstant,
+		Octaves.GetData(),
+		Octaves.Num(),
+		Args.Accumulation,
+		Args.bFastMath,
+		HilbertBlueTable,
+		bStats ? TypeCycles.Cycles : nullptr,
+		Args.Seed,
+		ReturnValue,
+		Num);
+
+	if (bStats)
+	{
+		AddProceduralNoiseStats(Octaves, TypeCycles, Num);
+	}
+}
+
+void VCET::EvaluateProceduralNoise(const FVCETProceduralNoiseArgs3D& Args, float* ReturnValue, const int32 Start, const int32 Num)
+{
+	TVoxelInlineArray<ispc::FProceduralOctave3D, 16> Octaves;
+	OffsetOctaves(Args, Start, Octaves);
+
+	const float* HilbertBlueTable = nullptr;
+	if (GVCETNoiseHilbertBlueTable &&
+		UsesNoise(Args.Octaves, ispc::ProceduralNoise3D_HilbertBlue))
+	{
+		HilbertBlueTable = GetHilbertBlueTable3D();
+	}
+
+	const bool bStats = AreProceduralNoiseStatsEnabled();
+	FProceduralNoiseTypeCycles TypeCycles;
+
+	ispc::VoxelNode_ProceduralNoise3D(
+		Args.Position[0].GetData(Start),
+		Args.Position[0].bConstant,
+		Args.Position[1].GetData(Start),
+		Args.Position[1].bConstant,
+		Args.Position[2].GetData(Start),
+		Args.Position[2].bConstant,
+		Args.Amplitude.GetData(Start),
+		Args.Amplitude.bConstant,
+		Args.FeatureScale.GetData(Start),
+		Args.FeatureScale.bConstant,
+		Args.Lacunarity.GetData(Start),
+		Args.Lacunarity.bConstant,
+		Args.Gain.GetData(Start),
+		Args.Gain.bConstant,
+		Args.VoronoiSmoothness.GetData(Start),
+		Args.VoronoiSmoothness.bConstant,
+		Args.WaveletPhase.GetData(Start),
+		Args.WaveletPhase.bConstant,
+		Args.ScratchSmoothness.GetData(Start),
+		Args.ScratchSmoothness.bConstant,
+		Octaves.GetData(),
+		Octaves.Num(),
+		Args.Accumulation,
+		Args.bFastMath,
+		HilbertBlueTable,
+		bStats ? TypeCycles.Cycles : nullptr,
+		Args.Seed,
+		ReturnValue,
+		Num);
+
+	if (bStats)
+	{
+		AddProceduralNoiseStats(Octaves, TypeCycles, Num);
+	}
+}
+
+template<typename ArgsType>
+void VCET::EvaluateProceduralNoiseParallel(const ArgsType& Args, float* ReturnValue, const int32 Num)
+{
+	// Below this, the ParallelFor overhead outweighs the chunk's work
+	const int32 ChunkSize = FMath::Max(GVCETNoiseParallelChunkSize, 1024);
+	const int32 NumChunks = FMath::DivideAndRoundUp(Num, ChunkSize);
+
+	if (GVCETNoiseParallelThreshold <= 0 ||
+		Num < GVCETNoiseParallelThreshold ||
+		NumChunks < 2)
+	{
+		EvaluateProceduralNoise(Args, ReturnValue, 0, Num);
+		return;
+	}
+
+	VOXEL_SCOPE_COUNTER_FORMAT("ProceduralNoise Parallel Num=%d Chunks=%d", Num, NumChunks);
+
+	// Chunks write disjoint ranges of ReturnValue, and the kernels are pure functions of their inputs:
+	// the result is bit-identical to a single call
+	ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+	{
+		const int32 Start = ChunkIndex * ChunkSize;
+		const int32 Count = FMath::Min(ChunkSize, Num - Start);
+
+		EvaluateProceduralNoise(Args, ReturnValue + Start, Start, Count);
+	});
+}
+
+template void VCET::EvaluateProceduralNoiseParallel(const FVCETProceduralNoiseArgs2D&, float*, int32);
+template void VCET::EvaluateProceduralNoiseParallel(const FVCETProceduralNoiseArgs3D&, float*, int32);
+
+template<typename ArgsType>
+void VCET::EvaluateProceduralNoiseMasked(const ArgsType& Args, const float* Mask, float* ReturnValue, const int32 Num)
+{
+	TVoxelArray<int32> ActiveIndices;
+	ActiveIndices.Reserve(Num);
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		if (Mask[Index] != 0.f)
+		{
+			ActiveIndices.Add(Index);
+		}
+	}
+
+	const int32 NumActive = ActiveIndices.Num();
+	VOXEL_SCOPE_COUNTER_FORMAT("ProceduralNoise Masked Num=%d Active=%d", Num, NumActive);
+
+	// Mostly active: gathering every input costs more than evaluating the few masked samples
+	if (NumActive >= Num - Num / 8)
+	{
+		EvaluateProceduralNoiseParallel(Args, ReturnValue, Num);
+
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			if (Mask[Index] == 0.f)
+			{
+				ReturnValue[Index] = 0.f;
+			}
+		}
+		return;
+	}
+
+	FMemory::Memzero(ReturnValue, Num * sizeof(float));
+
+	if (NumActive == 0)
+	{
+		return;
+	}
+
+	// One compacted copy per non-constant input, reserved upfront so that the data pointers stay valid
+	TVoxelArray<TVoxelArray<float>> CompactedData;
+	CompactedData.Reserve(UE_ARRAY_COUNT(Args.Position) + 7 + Args.Octaves.Num());
+
+	const auto Compact = [&](const float* Data)
+	{
+		TVoxelArray<float>& Compacted = CompactedData.Emplace_GetRef();
+		Compacted.SetNumUninitialized(NumActive);
+
+		for (int32 Index = 0; Index < NumActive; Index++)
+		{
+			Compacted[Index] = Data[ActiveIndices[Index]];
+		}
+		return Compacted.GetData();
+	};
+	const auto CompactStream = [&](const FVCETNoiseStream& Stream)
+	{
+		if (Stream.bConstant)
+		{
+			return Stream;
+		}
+		return FVCETNoiseStream(Compact(Stream.Data), false);
+	};
+
+	ArgsType CompactedArgs = Args;
+	for (FVCETNoiseStream& Position : CompactedArgs.Position)
+	{
+		Position = CompactStream(Position);
+	}
+	CompactedArgs.Amplitude = CompactStream(Args.Amplitude);
+	CompactedArgs.FeatureScale = CompactStream(Args.FeatureScale);
+	CompactedArgs.Lacunarity = CompactStream(Args.Lacunarity);
+	CompactedArgs.Gain = CompactStream(Args.Gain);
+	CompactedArgs.VoronoiSmoothness = CompactStream(Args.VoronoiSmoothness);
+	CompactedArgs.WaveletPhase = CompactStream(Args.WaveletPhase);
+	CompactedArgs.ScratchSmoothness = CompactStream(Args.ScratchSmoothness);
+
+	TVoxelArray<typename ArgsType::FOctave> CompactedOctaves;
+	CompactedOctaves.Append(Args.Octaves.GetData(), Args.Octaves.Num());
+	for (typename ArgsType::FOctave& Octave : CompactedOctaves)
+	{
+		if (!Octave.bStrengthIsConstant)
+		{
+			Octave.StrengthArray = Compact(Octave.StrengthArray);
+		}
+	}
+	CompactedArgs.Octaves = CompactedOctaves;
+
+	TVoxelArray<float> CompactedValues;
+	CompactedValues.SetNumUninitialized(NumActive);
+	EvaluateProceduralNoiseParallel(CompactedArgs, CompactedValues.GetData(), NumActive);
+
+	for (int32 Index = 0; Index < NumActive; Index++)
+	{
+		ReturnValue[ActiveIndices[Index]] = CompactedValues[Index];
+	}
+}
+
+template void VCET::EvaluateProceduralNoiseMasked(const FVCETProceduralNoiseArgs2D&, const float*, float*, int32);
+template void VCET::EvaluateProceduralNoiseMasked(const FVCETProceduralNoiseArgs3D&, const float*, float*, int32);
+
+bool VCET::EvaluateProceduralNoiseDeduplicated(const FVCETProceduralNoiseArgs2D& Args, float* ReturnValue, const int32 Num)
+{
+	if (!GVCETNoiseDeduplicateXY ||
+		Num < 64 ||
+		Args.Position[0].bConstant ||
+		Args.Position[1].bConstant)
+	{
+		return false;
+	}
+
+	// Only the positions may vary: any other per-sample input would have to be deduplicated too
+	if (!Args.Amplitude.bConstant ||
+		!Args.FeatureScale.bConstant ||
+		!Args.Lacunarity.bConstant ||
+		!Args.Gain.bConstant ||
+		!Args.VoronoiSmoothness.bConstant ||
+		!Args.WaveletPhase.bConstant ||
+		!Args.ScratchSmoothness.bConstant)
+	{
+		return false;
+	}
+	for (const ispc::FProceduralOctave2D& Octave : Args.Octaves)
+	{
+		if (!Octave.bStrengthIsConstant)
+		{
+			return false;
+		}
+	}
+
+	const float* X = Args.Position[0].Data;
+	const float* Y = Args.Position[1].Data;
+
+	const auto IsSameAsFirst = [&](const int32 Index)
+	{
+		return X[Index] == X[0] && Y[Index] == Y[0];
+	};
+
+	if (!IsSameAsFirst(1))
+	{
+		// Periodic layout, Z outermost: find the first sample back at the first position
+		int32 Period = 0;
+		for (int32 Index = 2; Index <= Num / 2; Index++)
+		{
+			if (IsSameAsFirst(Index))
+			{
+				Period = Index;
+				break;
+			}
+		}
+
+		if (Period == 0 ||
+			FMemory::Memcmp(X + Period, X, (Num - Period) * sizeof(float)) != 0 ||
+			FMemory::Memcmp(Y + Period, Y, (Num - Period) * sizeof(float)) != 0)
+		{
+			return false;
+		}
+
+		VOXEL_SCOPE_COUNTER_FORMAT("ProceduralNoise2D Deduplicated Num=%d Unique=%d", Num, Period);
+
+		EvaluateProceduralNoiseParallel(Args, ReturnValue, Period);
+
+		for (int32 Index = Period; Index < Num; Index += Period)
+		{
+			FMemory::Memcpy(ReturnValue + Index, ReturnValue, FMath::Min(Period, Num - Index) * sizeof(float));
+		}
+		return true;
+	}
+
+	// Runs, Z innermost: find the first sample at a different position
+	int32 RunLength = 2;
+	while (RunLength < Num && IsSameAsFirst(RunLength))
+	{
+		RunLength++;
+	}
+
+	if (RunLength > Num / 2)
+	{
+		return false;
+	}
+
+	for (int32 Index = RunLength; Index < Num; Index++)
+	{
+		const int32 RunStart = Index - Index % RunLength;
+		if (X[Index] != X[RunStart] ||
+			Y[Index] != Y[RunStart])
+		{
+			return false;
+		}
+	}
+
+	const int32 NumUnique = FMath::DivideAndRoundUp(Num, RunLength);
+	VOXEL_SCOPE_COUNTER_FORMAT("ProceduralNoise2D Deduplicated Num=%d Unique=%d", Num, NumUnique);
 
-FORCEINLINE ispc::EProceduralNoise2D GetISPCNoise(const EVoxelProceduralNoiseType2D Noise)
+	TVoxelArray<float> UniqueX;
+	TVoxelArray<float> UniqueY;
+	TVoxelArray<float> UniqueValues;
+	UniqueX.SetNumUninitialized(NumUnique);
+	UniqueY.SetNumUninitialized(NumUnique);
+	UniqueValues.SetNumUninitialized(NumUnique);
+
+	for (int32 Index = 0; Index < NumUnique; Index++)
+	{
+		UniqueX[Index] = X[Index * RunLength];
+		UniqueY[Index] = Y[Index * RunLength];
+	}
+
+	FVCETProceduralNoiseArgs2D UniqueArgs = Args;
+	UniqueArgs.Position[0] = FVCETNoiseStream(UniqueX.GetData(), false);
+	UniqueArgs.Position[1] = FVCETNoiseStream(UniqueY.GetData(), false);
+	EvaluateProceduralNoiseParallel(UniqueArgs, UniqueValues.GetData(), NumUnique);
+
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		ReturnValue[Index] = UniqueValues[Index / RunLength];
+	}
+	return true;
+}
+
+FString VCET::GetProceduralNoiseISPCTarget()
 {
-	switch (Noise)
-	{
-	default: ensure(false);
-
-#define CASE(Name) case EVoxelProceduralNoiseType2D::Name: return ispc::ProceduralNoise2D_ ## Name;
-
-	case EVoxelProceduralNoiseType2D::Default:
-	CASE(Perlin);
-	CASE(Simplex);
-	CASE(Value);
-	CASE(Worley);
-	CASE(Voronoi);
-	CASE(Blue);
-	CASE(HilbertBlue);
-	CASE(Crater);
-	CASE(Gabor);
-	CASE(Curl);
-	CASE(Scratch);
-	CASE(Wavelet);
-	CASE(Erosion);
-	CASE(Paper);
-	CASE(Stone);
-	CASE(Wool);
-	CASE(InterleavedGradient);
-
-#undef CASE
+	switch (ispc::ProceduralNoise_GetTarget())
+	{
+	default: return TEXT("Unknown");
+	case ispc::ProceduralNoiseTarget_SSE2: return TEXT("SSE2");
+	case ispc::ProceduralNoiseTarget_SSE4: return TEXT("SSE4");
+	case ispc::ProceduralNoiseTarget_AVX: return TEXT("AVX");
+	case ispc::ProceduralNoiseTarget_AVX2: return TEXT("AVX2");
+	case ispc::ProceduralNoiseTarget_AVX512: return TEXT("AVX512");
+	case ispc::ProceduralNoiseTarget_NEON: return TEXT("NEON");
 	}
 }
 
-FORCEINLINE ispc::EProceduralNoise3D GetISPCNoise(const EVoxelProceduralNoiseType3D Noise)
+int32 VCET::GetProceduralNoiseISPCWidth()
 {
-	switch (Noise)
-	{
-	default: ensure(false);
-
-#define CASE(Name) case EVoxelProceduralNoiseType3D::Name: return ispc::ProceduralNoise3D_ ## Name;
-
-	case EVoxelProceduralNoiseType3D::Default:
-	CASE(Perlin);
-	CASE(Simplex);
-	CASE(Value);
-	CASE(Worley);
-	CASE(Voronoi);
-	CASE(Blue);
-	CASE(HilbertBlue);
-	CASE(Crater);
-	CASE(Gabor);
-	CASE(Curl);
-	CASE(Scratch);
-	CASE(Wavelet);
-	CASE(Erosion);
-	CASE(Paper);
-	CASE(Stone);
-	CASE(Wool);
-	CASE(InterleavedGradient);
-
-#undef CASE
+	return ispc::ProceduralNoise_GetTargetWidth();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+namespace VCET
+{
+	// Bounds of each noise type, derived from the ISPC implementations
+	// Perlin max is sqrt(N)/2 for unit gradients, gradient noise derivative values are bounded by |G| * |Local - Corner|
+	// Simplex, Curl and Wool bounds are analytic worst cases, far from the values reached in practice
+	FFloatInterval GetNoiseTypeRange(const EVoxelProceduralNoiseType2D Type)
+	{
+		switch (Type)
+		{
+		default: ensure(false);
+		case EVoxelProceduralNoiseType2D::Default:
+		case EVoxelProceduralNoiseType2D::Perlin: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType2D::Simplex: return { -2.74f, 2.74f };
+		case EVoxelProceduralNoiseType2D::Value: return { -1.f, 1.f };
+		// Closest feature point is at most sqrt(2) away
+		case EVoxelProceduralNoiseType2D::Worley: return { -1.83f, 1.f };
+		case EVoxelProceduralNoiseType2D::Voronoi: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType2D::Blue: return { -1.8f, 1.8f };
+		case EVoxelProceduralNoiseType2D::HilbertBlue: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType2D::Crater: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType2D::Gabor: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType2D::Curl: return { -1.f, 9.f };
+		// Line fade is Local.y * 0.5 + 0.5 with |Local.y| <= sqrt(2) + 1
+		case EVoxelProceduralNoiseType2D::Scratch: return { -1.f, 2.42f };
+		case EVoxelProceduralNoiseType2D::Wavelet: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType2D::Erosion: return { -1.69f, 1.69f };
+		case EVoxelProceduralNoiseType2D::Paper: return { -0.2f, 1.f };
+		case EVoxelProceduralNoiseType2D::Stone: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType2D::Wool: return { -1.f, 16.f };
+		case EVoxelProceduralNoiseType2D::InterleavedGradient: return { -1.f, 1.f };
+		}
+	}
+	FFloatInterval GetNoiseTypeRange(const EVoxelProceduralNoiseType3D Type)
+	{
+		switch (Type)
+		{
+		default: ensure(false);
+		case EVoxelProceduralNoiseType3D::Default:
+		case EVoxelProceduralNoiseType3D::Perlin: return { -1.22f, 1.22f };
+		case EVoxelProceduralNoiseType3D::Simplex: return { -3.77f, 3.77f };
+		case EVoxelProceduralNoiseType3D::Value: return { -1.f, 1.f };
+		// Closest feature point is at most sqrt(3) away
+		case EVoxelProceduralNoiseType3D::Worley: return { -2.47f, 1.f };
+		case EVoxelProceduralNoiseType3D::Voronoi: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType3D::Blue: return { -1.8f, 1.96f };
+		case EVoxelProceduralNoiseType3D::HilbertBlue: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType3D::Crater: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType3D::Gabor: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType3D::Curl: return { -1.f, 11.2f };
+		// Strand fade is Local.y * 0.5 + 0.5 with |Local.y| <= sqrt(3) + 1
+		case EVoxelProceduralNoiseType3D::Scratch: return { -1.f, 2.74f };
+		case EVoxelProceduralNoiseType3D::Wavelet: return { -1.f, 1.f };
+		case EVoxelProceduralNoiseType3D::Erosion: return { -2.37f, 2.37f };
+		case EVoxelProceduralNoiseType3D::Paper: return { -0.2f, 1.f };
+		case EVoxelProceduralNoiseType3D::Stone: return { -1.22f, 1.22f };
+		case EVoxelProceduralNoiseType3D::Wool: return { -1.f, 23.5f };
+		case EVoxelProceduralNoiseType3D::InterleavedGradient: return { -1.f, 1.f };
+		}
+	}
+
+	// Mirrors the accumulation of the ISPC kernels: Sum(Noise * Strength * Amplitude) / Sum(|Strength * Amplitude|) * BaseAmplitude
+	// Every type range contains 0, which also covers octaves skipped for being non-finite and a zero amplitude sum
+	template<typename NoiseType>
+	FFloatInterval GetProceduralNoiseRange(const TVCETProceduralNoiseRangeInputs<NoiseType>& Inputs)
+	{
+		const int32 NumOctaves = FMath::Clamp(Inputs.NumOctaves, 1, 255);
+
+		const auto GetStrength = [&](const int32 Index)
+		{
+			return Inputs.OctaveStrengths.IsValidIndex(Index) ? Inputs.OctaveStrengths[Index] : FFloatInterval(1.f, 1.f);
+		};
+		const auto GetOctaveRange = [&](const int32 Index)
+		{
+			NoiseType Type = Inputs.DefaultNoiseType;
+			if (Inputs.OctaveTypes.IsValidIndex(Index) &&
+				Inputs.OctaveTypes[Index] != NoiseType::Default)
+			{
+				Type = Inputs.OctaveTypes[Index];
+			}
+
+			// See FCShapeOctave
+			const FFloatInterval Range = GetNoiseTypeRange(Type);
+			switch (Inputs.Accumulation)
+			{
+			default: ensure(false);
+			case EVoxelProceduralNoiseAccumulation::FBM: return Range;
+			case EVoxelProceduralNoiseAccumulation::Billow: return FFloatInterval(-1.f, FMath::Max(-Range.Min, Range.Max) * 2.f - 1.f);
+			case EVoxelProceduralNoiseAccumulation::Ridged:
+			case EVoxelProceduralNoiseAccumulation::HybridMultifractal: return FFloatInterval(-1.f, 1.f);
+			}
+		};
+
+		bool bWeightsAreConstant = Inputs.Gain.Min == Inputs.Gain.Max;
+		bool bWeightsArePositive = Inputs.Gain.Min >= 0.f;
+		for (int32 Index = 0; Index < NumOctaves; Index++)
+		{
+			const FFloatInterval Strength = GetStrength(Index);
+			bWeightsAreConstant &= Strength.Min == Strength.Max;
+			bWeightsArePositive &= Strength.Min >= 0.f;
+		}
+
+		double NormalizedMin = 0.;
+		double NormalizedMax = 0.;
+
+		if (bWeightsAreConstant)
+		{
+			double WeightSum = 0.;
+			float Amplitude = 1.f;
+			for (int32 Index = 0; Index < NumOctaves; Index++)
+			{
+				const FFloatInterval Range = GetOctaveRange(Index);
+				const double Weight = double(GetStrength(Index).Min) * Amplitude;
+
+				NormalizedMin += FMath::Min(Weight * Range.Min, Weight * Range.Max);
+				NormalizedMax += FMath::Max(Weight * Range.Min, Weight * Range.Max);
+				WeightSum += FMath::Abs(Weight);
+				Amplitude *= Inputs.Gain.Min;
+			}
+
+			if (WeightSum > 0.)
+			{
+				NormalizedMin /= WeightSum;
+				NormalizedMax /= WeightSum;
+			}
+			else
+			{
+				NormalizedMin = 0.;
+				NormalizedMax = 0.;
+			}
+		}
+		else
+		{
+			// Unknown weights: the normalized sum is a convex combination of the octaves' signed noises
+			for (int32 Index = 0; Index < NumOctaves; Index++)
+			{
+				const FFloatInterval Range = GetOctaveRange(Index);
+				NormalizedMin = FMath::Min<double>(NormalizedMin, Range.Min);
+				NormalizedMax = FMath::Max<double>(NormalizedMax, Range.Max);
+
+				if (!bWeightsArePositive)
+				{
+					NormalizedMin = FMath::Min<double>(NormalizedMin, -Range.Max);
+					NormalizedMax = FMath::Max<double>(NormalizedMax, -Range.Min);
+				}
+			}
+		}
+
+		// FastMath deviates by up to ProceduralNoiseFastMathMaxError at Amplitude = 1, that is in normalized units,
+		// plus float rounding in the kernels. Applied whether or not FastMath is on, since the inputs don't say
+		const double Margin =
+			ProceduralNoiseFastMathMaxError +
+			1.e-3 * FMath::Max(FMath::Abs(NormalizedMin), FMath::Abs(NormalizedMax));
+		NormalizedMin -= Margin;
+		NormalizedMax += Margin;
+
+		const double Products[] =
+		{
+			NormalizedMin * Inputs.Amplitude.Min,
+			NormalizedMin * Inputs.Amplitude.Max,
+			NormalizedMax * Inputs.Amplitude.Min,
+			NormalizedMax * Inputs.Amplitude.Max,
+		};
+
+		const double Min = FMath::Min(FMath::Min(Products[0], Products[1]), FMath::Min(Products[2], Products[3])) - UE_KINDA_SMALL_NUMBER;
+		const double Max = FMath::Max(FMath::Max(Products[0], Products[1]), FMath::Max(Products[2], Products[3])) + UE_KINDA_SMALL_NUMBER;
+
+		return FFloatInterval(float(Min), float(Max));
 	}
 }
 
+FFloatInterval FVoxelNode_ProceduralNoise2D::GetValueRange(const FVCETProceduralNoiseRangeInputs2D& Inputs)
+{
+	return VCET::GetProceduralNoiseRange(Inputs);
+}
+
+FFloatInterval FVoxelNode_ProceduralNoise3D::GetValueRange(const FVCETProceduralNoiseRangeInputs3D& Inputs)
+{
+	return VCET::GetProceduralNoiseRange(Inputs);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -73,6 +648,7 @@ FORCEINLINE ispc::EProceduralNoise3D GetISPCNoise(const EVoxelProceduralNoiseTyp
 void FVoxelNode_ProceduralNoise2D::Compute(const FVoxelGraphQuery Query) const
 {
 	const TValue<FVoxelVector2DBuffer> Positions = PositionPin.Get(Query);
+	const TValue<FVoxelFloatBuffer> Masks = MaskPin.Get(Query);
 	const TValue<FVoxelFloatBuffer> Amplitudes = AmplitudePin.Get(Query);
 	const TValue<FVoxelFloatBuffer> FeatureScales = FeatureScalePin.Get(Query);
 	const TValue<FVoxelFloatBuffer> Lacunarities = LacunarityPin.Get(Query);
@@ -82,13 +658,15 @@ void FVoxelNode_ProceduralNoise2D::Compute(const FVoxelGraphQuery Query) const
 	const TValue<FVoxelFloatBuffer> ScratchSmoothnesses = ScratchSmoothnessPin.Get(Query);
 	const TValue<int32> NumOctaves = NumOctavesPin.Get(Query);
 	const TValue<FVoxelSeed> Seed = SeedPin.Get(Query);
+	const TValue<EVoxelProceduralNoiseAccumulation> Accumulation = AccumulationPin.Get(Query);
 	const TValue<EVoxelProceduralNoiseType2D> DefaultNoiseType = DefaultNoiseTypePin.Get(Query);
 	const TVoxelArray<TValue<EVoxelProceduralNoiseType2D>> OctaveTypes = OctaveTypePins.Get(Query);
 	const TVoxelArray<TValue<FVoxelFloatBuffer>> OctaveStrengths = OctaveStrengthPins.Get(Query);
+	const TValue<bool> FastMath = FastMathPin.Get(Query);
 
-	VOXEL_GRAPH_WAIT(Positions, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses, NumOctaves, Seed, DefaultNoiseType, OctaveTypes, OctaveStrengths)
+	VOXEL_GRAPH_WAIT(Positions, Masks, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses, NumOctaves, Seed, Accumulation, DefaultNoiseType, OctaveTypes, OctaveStrengths, FastMath)
 	{
-		const int32 Num = ComputeVoxelBuffersNum(Positions, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses);
+		const int32 Num = ComputeVoxelBuffersNum(Positions, Masks, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses);
 		const int32 SafeNumOctaves = FMath::Clamp(NumOctaves, 1, 255);
 
 		TVoxelInlineArray<ispc::FProceduralOctave2D, 16> Octaves;
@@ -143,30 +721,33 @@ void FVoxelNode_ProceduralNoise2D::Compute(const FVoxelGraphQuery Query) const
 		FVoxelFloatBuffer ReturnValue;
 		ReturnValue.Allocate(Num);
 
-		ispc::VoxelNode_ProceduralNoise2D(
-			Positions->X.GetData(),
-			Positions->X.IsConstant(),
-			Positions->Y.GetData(),
-			Positions->Y.IsConstant(),
-			Amplitudes->GetData(),
-			Amplitudes->IsConstant(),
-			FeatureScales->GetData(),
-			FeatureScales->IsConstant(),
-			Lacunarities->GetData(),
-			Lacunarities->IsConstant(),
-			Gains->GetData(),
-			Gains->IsConstant(),
-			VoronoiSmoothnesses->GetData(),
-			VoronoiSmoothnesses->IsConstant(),
-			WaveletPhases->GetData(),
-			WaveletPhases->IsConstant(),
-			ScratchSmoothnesses->GetData(),
-			ScratchSmoothnesses->IsConstant(),
-			Octaves.GetData(),
-			Octaves.Num(),
-			Seed,
-			ReturnValue.GetData(),
-			Num);
+		FVCETProceduralNoiseArgs2D Args;
+		Args.Position[0] = Positions->X;
+		Args.Position[1] = Positions->Y;
+		Args.Amplitude = *Amplitudes;
+		Args.FeatureScale = *FeatureScales;
+		Args.Lacunarity = *Lacunarities;
+		Args.Gain = *Gains;
+		Args.VoronoiSmoothness = *VoronoiSmoothnesses;
+		Args.WaveletPhase = *WaveletPhases;
+		Args.ScratchSmoothness = *ScratchSmoothnesses;
+		Args.Octaves = Octaves;
+		Args.Accumulation = GetISPCAccumulation(Accumulation);
+		Args.Seed = Seed;
+		Args.bFastMath = FastMath;
+
+		if (!Masks->IsConstant())
+		{
+			VCET::EvaluateProceduralNoiseMasked(Args, Masks->GetData(), ReturnValue.GetData(), Num);
+		}
+		else if (Masks->GetConstant() == 0.f)
+		{
+			FMemory::Memzero(ReturnValue.GetData(), Num * sizeof(float));
+		}
+		else if (!VCET::EvaluateProceduralNoiseDeduplicated(Args, ReturnValue.GetData(), Num))
+		{
+			VCET::EvaluateProceduralNoiseParallel(Args, ReturnValue.GetData(), Num);
+		}
 
 		ValuePin.Set(Query, MoveTemp(ReturnValue));
 	};
@@ -179,6 +760,7 @@ void FVoxelNode_ProceduralNoise2D::Compute(const FVoxelGraphQuery Query) const
 void FVoxelNode_ProceduralNoise3D::Compute(const FVoxelGraphQuery Query) const
 {
 	const TValue<FVoxelVectorBuffer> Positions = PositionPin.Get(Query);
+	const TValue<FVoxelFloatBuffer> Masks = MaskPin.Get(Query);
 	const TValue<FVoxelFloatBuffer> Amplitudes = AmplitudePin.Get(Query);
 	const TValue<FVoxelFloatBuffer> FeatureScales = FeatureScalePin.Get(Query);
 	const TValue<FVoxelFloatBuffer> Lacunarities = LacunarityPin.Get(Query);
@@ -188,13 +770,15 @@ void FVoxelNode_ProceduralNoise3D::Compute(const FVoxelGraphQuery Query) const
 	const TValue<FVoxelFloatBuffer> ScratchSmoothnesses = ScratchSmoothnessPin.Get(Query);
 	const TValue<int32> NumOctaves = NumOctavesPin.Get(Query);
 	const TValue<FVoxelSeed> Seed = SeedPin.Get(Query);
+	const TValue<EVoxelProceduralNoiseAccumulation> Accumulation = AccumulationPin.Get(Query);
 	const TValue<EVoxelProceduralNoiseType3D> DefaultNoiseType = DefaultNoiseTypePin.Get(Query);
 	const TVoxelArray<TValue<EVoxelProceduralNoiseType3D>> OctaveTypes = OctaveTypePins.Get(Query);
 	const TVoxelArray<TValue<FVoxelFloatBuffer>> OctaveStrengths = OctaveStrengthPins.Get(Query);
+	const TValue<bool> FastMath = FastMathPin.Get(Query);
 
-	VOXEL_GRAPH_WAIT(Positions, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses, NumOctaves, Seed, DefaultNoiseType, OctaveTypes, OctaveStrengths)
+	VOXEL_GRAPH_WAIT(Positions, Masks, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses, NumOctaves, Seed, Accumulation, DefaultNoiseType, OctaveTypes, OctaveStrengths, FastMath)
 	{
-		const int32 Num = ComputeVoxelBuffersNum(Positions, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses);
+		const int32 Num = ComputeVoxelBuffersNum(Positions, Masks, Amplitudes, FeatureScales, Lacunarities, Gains, VoronoiSmoothnesses, WaveletPhases, ScratchSmoothnesses);
 		const int32 SafeNumOctaves = FMath::Clamp(NumOctaves, 1, 255);
 
 		TVoxelInlineArray<ispc::FProceduralOctave3D, 16> Octaves;
@@ -249,32 +833,34 @@ void FVoxelNode_ProceduralNoise3D::Compute(const FVoxelGraphQuery Query) const
 		FVoxelFloatBuffer ReturnValue;
 		ReturnValue.Allocate(Num);
 
-		ispc::VoxelNode_ProceduralNoise3D(
-			Positions->X.GetData(),
-			Positions->X.IsConstant(),
-			Positions->Y.GetData(),
-			Positions->Y.IsConstant(),
-			Positions->Z.GetData(),
-			Positions->Z.IsConstant(),
-			Amplitudes->GetData(),
-			Amplitudes->IsConstant(),
-			FeatureScales->GetData(),
-			FeatureScales->IsConstant(),
-			Lacunarities->GetData(),
-			Lacunarities->IsConstant(),
-			Gains->GetData(),
-			Gains->IsConstant(),
-			VoronoiSmoothnesses->GetData(),
-			VoronoiSmoothnesses->IsConstant(),
-			WaveletPhases->GetData(),
-			WaveletPhases->IsConstant(),
-			ScratchSmoothnesses->GetData(),
-			ScratchSmoothnesses->IsConstant(),
-			Octaves.GetData(),
-			Octaves.Num(),
-			Seed,
-			ReturnValue.GetData(),
-			Num);
+		FVCETProceduralNoiseArgs3D Args;
+		Args.Position[0] = Positions->X;
+		Args.Position[1] = Positions->Y;
+		Args.Position[2] = Positions->Z;
+		Args.Amplitude = *Amplitudes;
+		Args.FeatureScale = *FeatureScales;
+		Args.Lacunarity = *Lacunarities;
+		Args.Gain = *Gains;
+		Args.VoronoiSmoothness = *VoronoiSmoothnesses;
+		Args.WaveletPhase = *WaveletPhases;
+		Args.ScratchSmoothness = *ScratchSmoothnesses;
+		Args.Octaves = Octaves;
+		Args.Accumulation = GetISPCAccumulation(Accumulation);
+		Args.Seed = Seed;
+		Args.bFastMath = FastMath;
+
+		if (!Masks->IsConstant())
+		{
+			VCET::EvaluateProceduralNoiseMasked(Args, Masks->GetData(), ReturnValue.GetData(), Num);
+		}
+		else if (Masks->GetConstant() == 0.f)
+		{
+			FMemory::Memzero(ReturnValue.GetData(), Num * sizeof(float));
+		}
+		else
+		{
+			VCET::EvaluateProceduralNoiseParallel(Args, ReturnValue.GetData(), Num);
+		}
 
 		ValuePin.Set(Query, MoveTemp(ReturnValue));
 	};
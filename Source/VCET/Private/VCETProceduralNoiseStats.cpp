@@ -0,0 +1,207 @@
+// Copyright Zundle. MIT License.
+
+#include "VCETProceduralNoiseStats.h"
+#include "VCETProceduralNoiseKernel.h"
+#include "VCETModule.h"
+
+int32 GVCETNoiseStats = 0;
+static FAutoConsoleVariableRef CVarVCETNoiseStats(
+	TEXT("vcet.Noise.Stats"),
+	GVCETNoiseStats,
+	TEXT("If true, procedural noise kernels time each octave and report cycles and samples per noise type, as well as SIMD lane occupancy, ")
+	TEXT("to stat VCETNoise and vcet.Noise.DumpStats. Adds two clock reads per octave per SIMD gang."));
+
+#define VCET_FOREACH_NOISE_TYPE(Macro) \
+	Macro(Perlin) \
+	Macro(Simplex) \
+	Macro(Value) \
+	Macro(Worley) \
+	Macro(Voronoi) \
+	Macro(Blue) \
+	Macro(HilbertBlue) \
+	Macro(Crater) \
+	Macro(Gabor) \
+	Macro(Curl) \
+	Macro(Scratch) \
+	Macro(Wavelet) \
+	Macro(Erosion) \
+	Macro(Paper) \
+	Macro(Stone) \
+	Macro(Wool) \
+	Macro(InterleavedGradient)
+
+#define DECLARE_NOISE_TYPE_STATS(Name) \
+	DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT(#Name " Mcycles"), STAT_VCETNoise_ ## Name ## _Cycles, STATGROUP_VCETNoise); \
+	DECLARE_DWORD_ACCUMULATOR_STAT(TEXT(#Name " Samples"), STAT_VCETNoise_ ## Name ## _Samples, STATGROUP_VCETNoise);
+
+VCET_FOREACH_NOISE_TYPE(DECLARE_NOISE_TYPE_STATS);
+
+#undef DECLARE_NOISE_TYPE_STATS
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Kernel Calls"), STAT_VCETNoise_KernelCalls, STATGROUP_VCETNoise);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Lanes"), STAT_VCETNoise_ActiveLanes, STATGROUP_VCETNoise);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Issued Lanes"), STAT_VCETNoise_IssuedLanes, STATGROUP_VCETNoise);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Partial Gangs"), STAT_VCETNoise_PartialGangs, STATGROUP_VCETNoise);
+
+namespace VCET
+{
+	// Totals since startup or the last vcet.Noise.ResetStats, for builds without stats and for whole-session summaries
+	struct FProceduralNoiseTotals
+	{
+		std::atomic<int64> Cycles[ispc::ProceduralNoise2D_Num] = {};
+		std::atomic<int64> Samples[ispc::ProceduralNoise2D_Num] = {};
+		std::atomic<int64> KernelCalls = 0;
+		std::atomic<int64> ActiveLanes = 0;
+		std::atomic<int64> IssuedLanes = 0;
+		std::atomic<int64> PartialGangs = 0;
+
+		void Reset()
+		{
+			for (int32 Type = 0; Type < ispc::ProceduralNoise2D_Num; Type++)
+			{
+				Cycles[Type] = 0;
+				Samples[Type] = 0;
+			}
+			KernelCalls = 0;
+			ActiveLanes = 0;
+			IssuedLanes = 0;
+			PartialGangs = 0;
+		}
+	};
+	static FProceduralNoiseTotals GProceduralNoiseTotals;
+
+	static const TCHAR* GetNoiseTypeName(const int32 Type)
+	{
+		switch (Type)
+		{
+		default: return TEXT("Unknown");
+#define CASE(Name) case ispc::ProceduralNoise2D_ ## Name: return TEXT(#Name);
+		VCET_FOREACH_NOISE_TYPE(CASE)
+#undef CASE
+		}
+	}
+
+	static void AddNoiseTypeStats(const int32 Type, const double Cycles, const int64 Samples)
+	{
+		GProceduralNoiseTotals.Cycles[Type] += int64(Cycles);
+		GProceduralNoiseTotals.Samples[Type] += Samples;
+
+		switch (Type)
+		{
+		default: ensure(false); break;
+#define CASE(Name) \
+		case ispc::ProceduralNoise2D_ ## Name: \
+		{ \
+			INC_FLOAT_STAT_BY(STAT_VCETNoise_ ## Name ## _Cycles, Cycles / 1.e6); \
+			INC_DWORD_STAT_BY(STAT_VCETNoise_ ## Name ## _Samples, Samples); \
+		} \
+		break;
+		VCET_FOREACH_NOISE_TYPE(CASE)
+#undef CASE
+		}
+	}
+
+	template<typename OctaveType>
+	static void AddProceduralNoiseStatsImpl(const TConstVoxelArrayView<OctaveType> Octaves, const FProceduralNoiseTypeCycles& TypeCycles, const int32 Num)
+	{
+		if (Num <= 0)
+		{
+			return;
+		}
+
+		int32 NumOctaves[ispc::ProceduralNoise2D_Num] = {};
+		for (const OctaveType& Octave : Octaves)
+		{
+			NumOctaves[int32(Octave.Type)]++;
+		}
+
+		for (int32 Type = 0; Type < ispc::ProceduralNoise2D_Num; Type++)
+		{
+			if (NumOctaves[Type] > 0)
+			{
+				AddNoiseTypeStats(Type, TypeCycles.Cycles[Type], int64(NumOctaves[Type]) * Num);
+			}
+		}
+
+		// Every octave of the kernels runs over the full gang: the only idle lanes are the ones past Num in the last gang of the foreach
+		const int32 Width = GetProceduralNoiseISPCWidth();
+		const int32 IssuedLanes = FMath::DivideAndRoundUp(Num, Width) * Width;
+		const int32 PartialGangs = IssuedLanes != Num ? 1 : 0;
+
+		GProceduralNoiseTotals.KernelCalls++;
+		GProceduralNoiseTotals.ActiveLanes += Num;
+		GProceduralNoiseTotals.IssuedLanes += IssuedLanes;
+		GProceduralNoiseTotals.PartialGangs += PartialGangs;
+
+		INC_DWORD_STAT(STAT_VCETNoise_KernelCalls);
+		INC_DWORD_STAT_BY(STAT_VCETNoise_ActiveLanes, Num);
+		INC_DWORD_STAT_BY(STAT_VCETNoise_IssuedLanes, IssuedLanes);
+		INC_DWORD_STAT_BY(STAT_VCETNoise_PartialGangs, PartialGangs);
+	}
+}
+
+#undef VCET_FOREACH_NOISE_TYPE
+
+void VCET::AddProceduralNoiseStats(const TConstVoxelArrayView<ispc::FProceduralOctave2D> Octaves, const FProceduralNoiseTypeCycles& TypeCycles, const int32 Num)
+{
+	AddProceduralNoiseStatsImpl(Octaves, TypeCycles, Num);
+}
+
+void VCET::AddProceduralNoiseStats(const TConstVoxelArrayView<ispc::FProceduralOctave3D> Octaves, const FProceduralNoiseTypeCycles& TypeCycles, const int32 Num)
+{
+	AddProceduralNoiseStatsImpl(Octaves, TypeCycles, Num);
+}
+
+static FAutoConsoleCommand CmdVCETNoiseDumpStats(
+	TEXT("vcet.Noise.DumpStats"),
+	TEXT("Logs the procedural noise cycles and samples per noise type, and the SIMD lane occupancy, since startup or the last vcet.Noise.ResetStats. Requires vcet.Noise.Stats 1."),
+	FConsoleCommandDelegate::CreateLambda([]
+	{
+		using namespace VCET;
+
+		if (!AreProceduralNoiseStatsEnabled())
+		{
+			UE_LOG(LogVCET, Warning, TEXT("vcet.Noise.Stats is 0: no procedural noise stats are being recorded"));
+		}
+
+		int64 TotalCycles = 0;
+		for (int32 Type = 0; Type < ispc::ProceduralNoise2D_Num; Type++)
+		{
+			TotalCycles += GProceduralNoiseTotals.Cycles[Type];
+		}
+
+		UE_LOG(LogVCET, Display, TEXT("VCET procedural noise stats (%s, %d lanes):"), *GetProceduralNoiseISPCTarget(), GetProceduralNoiseISPCWidth());
+
+		for (int32 Type = 0; Type < ispc::ProceduralNoise2D_Num; Type++)
+		{
+			const int64 Cycles = GProceduralNoiseTotals.Cycles[Type];
+			const int64 Samples = GProceduralNoiseTotals.Samples[Type];
+			if (Samples == 0)
+			{
+				continue;
+			}
+
+			UE_LOG(LogVCET, Display, TEXT("  %-20s %14lld samples %12.2f Mcycles %8.2f cycles/sample %6.2f%%"),
+				GetNoiseTypeName(Type),
+				Samples,
+				Cycles / 1.e6,
+				double(Cycles) / Samples,
+				TotalCycles > 0 ? 100. * Cycles / TotalCycles : 0.);
+		}
+
+		const int64 ActiveLanes = GProceduralNoiseTotals.ActiveLanes;
+		const int64 IssuedLanes = GProceduralNoiseTotals.IssuedLanes;
+
+		UE_LOG(LogVCET, Display, TEXT("  %lld kernel calls, %lld with a partial last gang, lane occupancy %.2f%%"),
+			GProceduralNoiseTotals.KernelCalls.load(),
+			GProceduralNoiseTotals.PartialGangs.load(),
+			IssuedLanes > 0 ? 100. * ActiveLanes / IssuedLanes : 100.);
+	}));
+
+static FAutoConsoleCommand CmdVCETNoiseResetStats(
+	TEXT("vcet.Noise.ResetStats"),
+	TEXT("Resets the totals logged by vcet.Noise.DumpStats."),
+	FConsoleCommandDelegate::CreateLambda([]
+	{
+		VCET::GProceduralNoiseTotals.Reset();
+	}));
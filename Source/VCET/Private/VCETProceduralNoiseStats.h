@@ -0,0 +1,31 @@
+// Copyright Zundle. MIT License.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+#include "VCETProceduralNoiseNodesImpl.ispc.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("VCET Noise"), STATGROUP_VCETNoise, STATCAT_Advanced);
+
+extern int32 GVCETNoiseStats;
+
+namespace VCET
+{
+	static_assert(int32(ispc::ProceduralNoise2D_Num) == int32(ispc::ProceduralNoise3D_Num), "");
+
+	// Cycles spent in each noise type by one kernel call, indexed by ispc::EProceduralNoise2D/3D
+	// Passed to the kernels only when vcet.Noise.Stats is enabled
+	struct FProceduralNoiseTypeCycles
+	{
+		double Cycles[ispc::ProceduralNoise2D_Num] = {};
+	};
+
+	FORCEINLINE bool AreProceduralNoiseStatsEnabled()
+	{
+		return GVCETNoiseStats != 0;
+	}
+
+	// Adds the cost of one kernel call of Num samples to the STATGROUP_VCETNoise counters and to the running totals
+	void AddProceduralNoiseStats(TConstVoxelArrayView<ispc::FProceduralOctave2D> Octaves, const FProceduralNoiseTypeCycles& TypeCycles, int32 Num);
+	void AddProceduralNoiseStats(TConstVoxelArrayView<ispc::FProceduralOctave3D> Octaves, const FProceduralNoiseTypeCycles& TypeCycles, int32 Num);
+}
@@ -0,0 +1,512 @@
+// Copyright Zundle. MIT License.
+
+#include "VCETProceduralNoiseTileNodes.h"
+#include "VCETProceduralNoiseKernel.h"
+#include "VCETBakeStats.h"
+#include "VCETBakeMemory.h"
+#include "Async/ParallelFor.h"
+
+static int32 GVCETNoiseTileCacheMB = 256;
+static FAutoConsoleVariableRef CVarVCETNoiseTileCacheMB(
+	TEXT("vcet.Noise.TileCacheMB"),
+	GVCETNoiseTileCacheMB,
+	TEXT("Budget of the baked procedural noise tiles, in MB. Beyond it, the least recently used tiles are freed and baked again on next use. 0 is unlimited."));
+
+namespace VCET
+{
+	// Everything a baked tile depends on. Amplitude and FeatureScale are applied at lookup
+	struct FNoiseTileConfig
+	{
+		int32 Dimension = 0;
+		int32 Resolution = 0;
+		int32 Period = 0;
+		float Lacunarity = 0.f;
+		float Gain = 0.f;
+		float VoronoiSmoothness = 0.f;
+		float WaveletPhase = 0.f;
+		float ScratchSmoothness = 0.f;
+		int32 Seed = 0;
+		ispc::EProceduralAccumulation Accumulation = ispc::ProceduralAccumulation_FBM;
+		bool bFastMath = false;
+		// ISPC noise type of each octave
+		TVoxelArray<int32> OctaveTypes;
+		TVoxelArray<float> OctaveStrengths;
+
+		bool operator==(const FNoiseTileConfig& Other) const
+		{
+			return
+				Dimension == Other.Dimension &&
+				Resolution == Other.Resolution &&
+				Period == Other.Period &&
+				Lacunarity == Other.Lacunarity &&
+				Gain == Other.Gain &&
+				VoronoiSmoothness == Other.VoronoiSmoothness &&
+				WaveletPhase == Other.WaveletPhase &&
+				ScratchSmoothness == Other.ScratchSmoothness &&
+				Seed == Other.Seed &&
+				Accumulation == Other.Accumulation &&
+				bFastMath == Other.bFastMath &&
+				OctaveTypes == Other.OctaveTypes &&
+				OctaveStrengths == Other.OctaveStrengths;
+		}
+		friend uint32 GetTypeHash(const FNoiseTileConfig& Config)
+		{
+			uint32 Hash = HashCombineFast(GetTypeHash(Config.Dimension), GetTypeHash(Config.Resolution));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.Period));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.Lacunarity));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.Gain));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.VoronoiSmoothness));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.WaveletPhase));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.ScratchSmoothness));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.Seed));
+			Hash = HashCombineFast(Hash, GetTypeHash(int32(Config.Accumulation)));
+			Hash = HashCombineFast(Hash, GetTypeHash(Config.bFastMath));
+			for (int32 Index = 0; Index < Config.OctaveTypes.Num(); Index++)
+			{
+				Hash = HashCombineFast(Hash, GetTypeHash(Config.OctaveTypes[Index]));
+				Hash = HashCombineFast(Hash, GetTypeHash(Config.OctaveStrengths[Index]));
+			}
+			return Hash;
+		}
+	};
+
+	// Immutable once published to the cache
+	struct FNoiseTile
+	{
+		TVoxelArray<float> Texels;
+	};
+
+	struct FNoiseTileEntry
+	{
+		TSharedPtr<const FNoiseTile> Tile;
+		int64 Bytes = 0;
+		uint64 LastUse = 0;
+	};
+
+	// Evicted tiles stay alive until the graphs sampling them release their reference
+	static FCriticalSection GNoiseTilesCriticalSection;
+	static TMap<FNoiseTileConfig, FNoiseTileEntry> GNoiseTiles;
+	static int64 GNoiseTilesBytes = 0;
+	static uint64 GNoiseTilesUseCounter = 0;
+
+	// Frees the least recently used tiles until the cache holds at most MaxBytes. Returns the bytes freed
+	static int64 TrimNoiseTiles_AssumeLocked(const int64 MaxBytes)
+	{
+		int64 BytesFreed = 0;
+		while (GNoiseTilesBytes > MaxBytes && GNoiseTiles.Num() > 0)
+		{
+			const FNoiseTileConfig* OldestConfig = nullptr;
+			uint64 OldestUse = MAX_uint64;
+			for (const TPair<FNoiseTileConfig, FNoiseTileEntry>& It : GNoiseTiles)
+			{
+				if (It.Value.LastUse < OldestUse)
+				{
+					OldestConfig = &It.Key;
+					OldestUse = It.Value.LastUse;
+				}
+			}
+
+			const int64 Bytes = GNoiseTiles[*OldestConfig].Bytes;
+			GNoiseTiles.Remove(*OldestConfig);
+			GNoiseTilesBytes -= Bytes;
+			BytesFreed += Bytes;
+		}
+		return BytesFreed;
+	}
+
+	static FAutoConsoleCommand CmdClearNoiseTiles(
+		TEXT("vcet.Noise.ClearTileCache"),
+		TEXT("Frees all baked procedural noise tiles. They are baked again on next use."),
+		FConsoleCommandDelegate::CreateLambda([]
+		{
+			FScopeLock Lock(&GNoiseTilesCriticalSection);
+			TrimNoiseTiles_AssumeLocked(0);
+		}));
+
+	int64 GetNoiseTileCacheBytes()
+	{
+		FScopeLock Lock(&GNoiseTilesCriticalSection);
+		return GNoiseTilesBytes;
+	}
+
+	int64 EvictNoiseTiles(const int64 BytesToFree)
+	{
+		FScopeLock Lock(&GNoiseTilesCriticalSection);
+		return TrimNoiseTiles_AssumeLocked(FMath::Max<int64>(GNoiseTilesBytes - BytesToFree, 0));
+	}
+
+	template<int32 Dimension>
+	static void BakeNoiseTile(const FNoiseTileConfig& Config, TVoxelArray<float>& OutTexels)
+	{
+		VOXEL_SCOPE_COUNTER_FORMAT("Bake noise tile %dD Resolution=%d", Dimension, Config.Resolution);
+
+		using FArgs = TVCETProceduralNoiseArgs<Dimension>;
+
+		const int32 Resolution = Config.Resolution;
+		const float Period = Config.Period;
+		const int32 NumRows = Dimension == 2 ? Resolution : Resolution * Resolution;
+
+		TVoxelArray<typename FArgs::FOctave> Octaves;
+		for (int32 Index = 0; Index < Config.OctaveTypes.Num(); Index++)
+		{
+			typename FArgs::FOctave& Octave = Octaves.Emplace_GetRef();
+			FMemory::Memzero(Octave);
+			Octave.Type = decltype(Octave.Type)(Config.OctaveTypes[Index]);
+			Octave.bStrengthIsConstant = true;
+			Octave.StrengthConstant = Config.OctaveStrengths[Index];
+		}
+
+		// Bake in noise units, FeatureScale is applied at lookup
+		const float One = 1.f;
+
+		FArgs BaseArgs;
+		BaseArgs.Amplitude = FVCETNoiseStream(&One, true);
+		BaseArgs.FeatureScale = FVCETNoiseStream(&One, true);
+		BaseArgs.Lacunarity = FVCETNoiseStream(&Config.Lacunarity, true);
+		BaseArgs.Gain = FVCETNoiseStream(&Config.Gain, true);
+		BaseArgs.VoronoiSmoothness = FVCETNoiseStream(&Config.VoronoiSmoothness, true);
+		BaseArgs.WaveletPhase = FVCETNoiseStream(&Config.WaveletPhase, true);
+		BaseArgs.ScratchSmoothness = FVCETNoiseStream(&Config.ScratchSmoothness, true);
+		BaseArgs.Octaves = Octaves;
+		BaseArgs.Accumulation = Config.Accumulation;
+		BaseArgs.Seed = Config.Seed;
+		BaseArgs.bFastMath = Config.bFastMath;
+
+		OutTexels.SetNumUninitialized(NumRows * Resolution);
+
+		// Each texel is the blend of the noise at P - Offset * Period for every corner Offset of the unit square/cube,
+		// weighted by the (bi/tri)linear weight of that corner. At P = 0 and P = Period the blends match, making the tile periodic
+		ParallelFor(NumRows, [&](const int32 RowIndex)
+		{
+			const auto GetCoordinate = [&](const int32 Index)
+			{
+				return (Index + 0.5f) * Period / Resolution;
+			};
+
+			const float CoordinateY = GetCoordinate(RowIndex % Resolution);
+			const float CoordinateZ = GetCoordinate(RowIndex / Resolution);
+
+			TVoxelArray<float> CoordinatesX[2];
+			CoordinatesX[0].SetNumUninitialized(Resolution);
+			CoordinatesX[1].SetNumUninitialized(Resolution);
+			for (int32 Index = 0; Index < Resolution; Index++)
+			{
+				CoordinatesX[0][Index] = GetCoordinate(Index);
+				CoordinatesX[1][Index] = GetCoordinate(Index) - Period;
+			}
+
+			TVoxelArray<float> Noise;
+			Noise.SetNumUninitialized(Resolution);
+
+			float* Row = OutTexels.GetData() + int64(RowIndex) * Resolution;
+			FMemory::Memzero(Row, Resolution * sizeof(float));
+
+			for (int32 Corner = 0; Corner < (1 << Dimension); Corner++)
+			{
+				const bool bOffsetX = (Corner & 1) != 0;
+				const bool bOffsetY = (Corner & 2) != 0;
+				const bool bOffsetZ = (Corner & 4) != 0;
+
+				const float PositionY = CoordinateY - (bOffsetY ? Period : 0.f);
+				const float PositionZ = CoordinateZ - (bOffsetZ ? Period : 0.f);
+
+				FArgs Args = BaseArgs;
+				Args.Position[0] = FVCETNoiseStream(CoordinatesX[bOffsetX].GetData(), false);
+				Args.Position[1] = FVCETNoiseStream(&PositionY, true);
+				if constexpr (Dimension == 3)
+				{
+					Args.Position[2] = FVCETNoiseStream(&PositionZ, true);
+				}
+
+				EvaluateProceduralNoise(Args, Noise.GetData(), 0, Resolution);
+
+				const float AlphaY = CoordinateY / Period;
+				const float AlphaZ = CoordinateZ / Period;
+
+				float Weight = bOffsetY ? AlphaY : 1.f - AlphaY;
+				if constexpr (Dimension == 3)
+				{
+					Weight *= bOffsetZ ? AlphaZ : 1.f - AlphaZ;
+				}
+
+				for (int32 Index = 0; Index < Resolution; Index++)
+				{
+					const float AlphaX = CoordinatesX[0][Index] / Period;
+					Row[Index] += Noise[Index] * Weight * (bOffsetX ? AlphaX : 1.f - AlphaX);
+				}
+			}
+		});
+	}
+
+	// Returns the texels of the tile, baking it if it isn't cached
+	// The bake holds no lock: graph threads missing the same configuration at the same time each bake it, and the first
+	// tile published is the one kept. Duplicate bakes are limited to the first use of a configuration, while waiting on
+	// another thread's bake would stall every graph thread needing the tile
+	static TSharedRef<const FNoiseTile> FindOrBakeNoiseTile(const FNoiseTileConfig& Config)
+	{
+		{
+			FScopeLock Lock(&GNoiseTilesCriticalSection);
+
+			if (FNoiseTileEntry* Entry = GNoiseTiles.Find(Config))
+			{
+				Entry->LastUse = ++GNoiseTilesUseCounter;
+				return Entry->Tile.ToSharedRef();
+			}
+		}
+
+		TSharedPtr<FNoiseTile> NewTile;
+		{
+			LLM_SCOPE_BYTAG(VCET_Cache);
+
+			NewTile = MakeShared<FNoiseTile>();
+			if (Config.Dimension == 2)
+			{
+				BakeNoiseTile<2>(Config, NewTile->Texels);
+			}
+			else
+			{
+				BakeNoiseTile<3>(Config, NewTile->Texels);
+			}
+		}
+
+		FScopeLock Lock(&GNoiseTilesCriticalSection);
+
+		FNoiseTileEntry& Entry = GNoiseTiles.FindOrAdd(Config);
+		if (!Entry.Tile)
+		{
+			Entry.Tile = NewTile;
+			Entry.Bytes = NewTile->Texels.GetAllocatedSize();
+			GNoiseTilesBytes += Entry.Bytes;
+		}
+		Entry.LastUse = ++GNoiseTilesUseCounter;
+
+		const TSharedRef<const FNoiseTile> Tile = Entry.Tile.ToSharedRef();
+
+		// The tile just used is the most recent, it is only evicted if it alone exceeds the budget
+		if (GVCETNoiseTileCacheMB > 0)
+		{
+			TrimNoiseTiles_AssumeLocked(GVCETNoiseTileCacheMB * int64(1024 * 1024));
+		}
+		return Tile;
+	}
+
+	template<typename NoiseType>
+	static FNoiseTileConfig MakeNoiseTileConfig(
+		const int32 Dimension,
+		const int32 Resolution,
+		const int32 Period,
+		const float Lacunarity,
+		const float Gain,
+		const float VoronoiSmoothness,
+		const float WaveletPhase,
+		const float ScratchSmoothness,
+		const int32 Seed,
+		const EVoxelProceduralNoiseAccumulation Accumulation,
+		const bool bFastMath,
+		const int32 NumOctaves,
+		const NoiseType DefaultNoiseType,
+		const TConstVoxelArrayView<NoiseType> OctaveTypes,
+		const TConstVoxelArrayView<float> OctaveStrengths)
+	{
+		FNoiseTileConfig Config;
+		Config.Dimension = Dimension;
+		Config.Resolution = FMath::RoundUpToPowerOfTwo(FMath::Clamp(Resolution, Dimension == 2 ? 16 : 8, Dimension == 2 ? 2048 : 128));
+		Config.Period = FMath::Max(Period, 1);
+		Config.Lacunarity = Lacunarity;
+		Config.Gain = Gain;
+		Config.VoronoiSmoothness = VoronoiSmoothness;
+		Config.WaveletPhase = WaveletPhase;
+		Config.ScratchSmoothness = ScratchSmoothness;
+		Config.Seed = Seed;
+		Config.Accumulation = GetISPCAccumulation(Accumulation);
+		Config.bFastMath = bFastMath;
+
+		const int32 SafeNumOctaves = FMath::Clamp(NumOctaves, 1, 255);
+		for (int32 Index = 0; Index < SafeNumOctaves; Index++)
+		{
+			const bool bOverride =
+				OctaveTypes.IsValidIndex(Index) &&
+				OctaveTypes[Index] != NoiseType::Default;
+
+			Config.OctaveTypes.Add(int32(GetISPCNoise(bOverride ? OctaveTypes[Index] : DefaultNoiseType)));
+			Config.OctaveStrengths.Add(OctaveStrengths.IsValidIndex(Index) ? OctaveStrengths[Index] : 1.f);
+		}
+
+		// The phase only changes Wavelet octaves: without any, it must not split the cache into identical tiles
+		if (!Config.OctaveTypes.Contains(int32(GetISPCNoise(NoiseType::Wavelet))))
+		{
+			Config.WaveletPhase = 0.f;
+		}
+		return Config;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelNode_ProceduralNoiseTile2D::Compute(const FVoxelGraphQuery Query) const
+{
+	const TValue<FVoxelVector2DBuffer> Positions = PositionPin.Get(Query);
+	const TValue<FVoxelFloatBuffer> Amplitudes = AmplitudePin.Get(Query);
+	const TValue<float> FeatureScale = FeatureScalePin.Get(Query);
+	const TValue<float> Lacunarity = LacunarityPin.Get(Query);
+	const TValue<float> Gain = GainPin.Get(Query);
+	const TValue<float> VoronoiSmoothness = VoronoiSmoothnessPin.Get(Query);
+	const TValue<float> WaveletPhase = WaveletPhasePin.Get(Query);
+	const TValue<float> ScratchSmoothness = ScratchSmoothnessPin.Get(Query);
+	const TValue<int32> NumOctaves = NumOctavesPin.Get(Query);
+	const TValue<FVoxelSeed> Seed = SeedPin.Get(Query);
+	const TValue<int32> Period = PeriodPin.Get(Query);
+	const TValue<int32> Resolution = ResolutionPin.Get(Query);
+	const TValue<EVoxelProceduralNoiseAccumulation> Accumulation = AccumulationPin.Get(Query);
+	const TValue<EVoxelProceduralNoiseType2D> DefaultNoiseType = DefaultNoiseTypePin.Get(Query);
+	const TVoxelArray<TValue<EVoxelProceduralNoiseType2D>> OctaveTypes = OctaveTypePins.Get(Query);
+	const TVoxelArray<TValue<float>> OctaveStrengths = OctaveStrengthPins.Get(Query);
+	const TValue<EVoxelProceduralNoiseTileFilter> Filter = FilterPin.Get(Query);
+	const TValue<bool> FastMath = FastMathPin.Get(Query);
+
+	VOXEL_GRAPH_WAIT(Positions, Amplitudes, FeatureScale, Lacunarity, Gain, VoronoiSmoothness, WaveletPhase, ScratchSmoothness, NumOctaves, Seed, Period, Resolution, Accumulation, DefaultNoiseType, OctaveTypes, OctaveStrengths, Filter, FastMath)
+	{
+		const int32 Num = ComputeVoxelBuffersNum(Positions, Amplitudes);
+
+		TVoxelArray<EVoxelProceduralNoiseType2D> OctaveTypeValues;
+		for (int32 Index = 0; Index < OctaveTypes.Num(); Index++)
+		{
+			OctaveTypeValues.Add(OctaveTypes[Index]);
+		}
+
+		TVoxelArray<float> OctaveStrengthValues;
+		for (int32 Index = 0; Index < OctaveStrengths.Num(); Index++)
+		{
+			OctaveStrengthValues.Add(OctaveStrengths[Index]);
+		}
+
+		const VCET::FNoiseTileConfig Config = VCET::MakeNoiseTileConfig<EVoxelProceduralNoiseType2D>(
+			2,
+			Resolution,
+			Period,
+			Lacunarity,
+			Gain,
+			VoronoiSmoothness,
+			WaveletPhase,
+			ScratchSmoothness,
+			Seed,
+			Accumulation,
+			FastMath,
+			NumOctaves,
+			DefaultNoiseType,
+			OctaveTypeValues,
+			OctaveStrengthValues);
+
+		const TSharedRef<const VCET::FNoiseTile> Tile = VCET::FindOrBakeNoiseTile(Config);
+
+		VOXEL_SCOPE_COUNTER_FORMAT("ProceduralNoiseTile2D Num=%d", Num);
+		FVoxelNodeStatScope StatScope(*this, Num);
+
+		FVoxelFloatBuffer ReturnValue;
+		ReturnValue.Allocate(Num);
+
+		ispc::ProceduralNoise_SampleTile2D(
+			Tile->Texels.GetData(),
+			Config.Resolution,
+			Config.Resolution / (FMath::Max<float>(FeatureScale, UE_KINDA_SMALL_NUMBER) * Config.Period),
+			Filter == EVoxelProceduralNoiseTileFilter::Cubic,
+			Positions->X.GetData(),
+			Positions->X.IsConstant(),
+			Positions->Y.GetData(),
+			Positions->Y.IsConstant(),
+			Amplitudes->GetData(),
+			Amplitudes->IsConstant(),
+			ReturnValue.GetData(),
+			Num);
+
+		ValuePin.Set(Query, MoveTemp(ReturnValue));
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelNode_ProceduralNoiseTile3D::Compute(const FVoxelGraphQuery Query) const
+{
+	const TValue<FVoxelVectorBuffer> Positions = PositionPin.Get(Query);
+	const TValue<FVoxelFloatBuffer> Amplitudes = AmplitudePin.Get(Query);
+	const TValue<float> FeatureScale = FeatureScalePin.Get(Query);
+	const TValue<float> Lacunarity = LacunarityPin.Get(Query);
+	const TValue<float> Gain = GainPin.Get(Query);
+	const TValue<float> VoronoiSmoothness = VoronoiSmoothnessPin.Get(Query);
+	const TValue<float> WaveletPhase = WaveletPhasePin.Get(Query);
+	const TValue<float> ScratchSmoothness = ScratchSmoothnessPin.Get(Query);
+	const TValue<int32> NumOctaves = NumOctavesPin.Get(Query);
+	const TValue<FVoxelSeed> Seed = SeedPin.Get(Query);
+	const TValue<int32> Period = PeriodPin.Get(Query);
+	const TValue<int32> Resolution = ResolutionPin.Get(Query);
+	const TValue<EVoxelProceduralNoiseAccumulation> Accumulation = AccumulationPin.Get(Query);
+	const TValue<EVoxelProceduralNoiseType3D> DefaultNoiseType = DefaultNoiseTypePin.Get(Query);
+	const TVoxelArray<TValue<EVoxelProceduralNoiseType3D>> OctaveTypes = OctaveTypePins.Get(Query);
+	const TVoxelArray<TValue<float>> OctaveStrengths = OctaveStrengthPins.Get(Query);
+	const TValue<EVoxelProceduralNoiseTileFilter> Filter = FilterPin.Get(Query);
+	const TValue<bool> FastMath = FastMathPin.Get(Query);
+
+	VOXEL_GRAPH_WAIT(Positions, Amplitudes, FeatureScale, Lacunarity, Gain, VoronoiSmoothness, WaveletPhase, ScratchSmoothness, NumOctaves, Seed, Period, Resolution, Accumulation, DefaultNoiseType, OctaveTypes, OctaveStrengths, Filter, FastMath)
+	{
+		const int32 Num = ComputeVoxelBuffersNum(Positions, Amplitudes);
+
+		TVoxelArray<EVoxelProceduralNoiseType3D> OctaveTypeValues;
+		for (int32 Index = 0; Index < OctaveTypes.Num(); Index++)
+		{
+			OctaveTypeValues.Add(OctaveTypes[Index]);
+		}
+
+		TVoxelArray<float> OctaveStrengthValues;
+		for (int32 Index = 0; Index < OctaveStrengths.Num(); Index++)
+		{
+			OctaveStrengthValues.Add(OctaveStrengths[Index]);
+		}
+
+		const VCET::FNoiseTileConfig Config = VCET::MakeNoiseTileConfig<EVoxelProceduralNoiseType3D>(
+			3,
+			Resolution,
+			Period,
+			Lacunarity,
+			Gain,
+			VoronoiSmoothness,
+			WaveletPhase,
+			ScratchSmoothness,
+			Seed,
+			Accumulation,
+			FastMath,
+			NumOctaves,
+			DefaultNoiseType,
+			OctaveTypeValues,
+			OctaveStrengthValues);
+
+		const TSharedRef<const VCET::FNoiseTile> Tile = VCET::FindOrBakeNoiseTile(Config);
+
+		VOXEL_SCOPE_COUNTER_FORMAT("ProceduralNoiseTile3D Num=%d", Num);
+		FVoxelNodeStatScope StatScope(*this, Num);
+
+		FVoxelFloatBuffer ReturnValue;
+		ReturnValue.Allocate(Num);
+
+		ispc::ProceduralNoise_SampleTile3D(
+			Tile->Texels.GetData(),
+			Config.Resolution,
+			Config.Resolution / (FMath::Max<float>(FeatureScale, UE_KINDA_SMALL_NUMBER) * Config.Period),
+			Filter == EVoxelProceduralNoiseTileFilter::Cubic,
+			Positions->X.GetData(),
+			Positions->X.IsConstant(),
+			Positions->Y.GetData(),
+			Positions->Y.IsConstant(),
+			Positions->Z.GetData(),
+			Positions->Z.IsConstant(),
+			Amplitudes->GetData(),
+			Amplitudes->IsConstant(),
+			ReturnValue.GetData(),
+			Num);
+
+		ValuePin.Set(Query, MoveTemp(ReturnValue));
+	};
+}
@@ -0,0 +1,89 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VCETSyntheticLayer.h"
+
+namespace VCET
+{
+    // Offsets decorrelating the float and color metadata from the displacement
+    const FVector SyntheticFloatOffset = FVector(137.1, -59.3, 12.7);
+    const FVector SyntheticColorOffset = FVector(-41.9, 73.3, -88.1);
+
+    template<typename ValueType, typename LambdaType>
+    void SampleSynthetic(const FVoxelDoubleVectorBuffer& Positions, TArray<ValueType>& OutValues, LambdaType&& Lambda)
+    {
+        const int32 Num = Positions.Num();
+        OutValues.SetNumUninitialized(Num);
+
+        const double* X = Positions.X.GetData();
+        const double* Y = Positions.Y.GetData();
+        const double* Z = Positions.Z.GetData();
+        for (int32 Index = 0; Index < Num; Index++)
+        {
+            OutValues[Index] = Lambda(FVector(X[Index], Y[Index], Z[Index]));
+        }
+    }
+}
+
+double VCET::FSyntheticLayer::GetNoise(const FVector& Position, const FVector& Offset) const
+{
+    return FMath::PerlinNoise3D(Position / NoiseScale + Offset);
+}
+
+double VCET::FSyntheticLayer::GetDistance(const FVector& Position) const
+{
+    const double Sphere = FVector::Distance(Position, SphereCenter) - SphereRadius;
+
+    const FVector Q = (Position - BoxCenter).GetAbs() - BoxExtent;
+    const double Box = Q.ComponentMax(FVector::ZeroVector).Size() + FMath::Min(Q.GetMax(), 0.);
+
+    double Distance = FMath::Min(Sphere, Box);
+    if (NoiseAmplitude != 0.)
+    {
+        Distance += NoiseAmplitude * GetNoise(Position, FVector::ZeroVector);
+    }
+    return Distance;
+}
+
+float VCET::FSyntheticLayer::GetFloat(const FVector& Position) const
+{
+    return float(GetNoise(Position, SyntheticFloatOffset));
+}
+
+FLinearColor VCET::FSyntheticLayer::GetColor(const FVector& Position) const
+{
+    const float Noise = float(GetNoise(Position, SyntheticColorOffset)) * 0.5f + 0.5f;
+    const float Depth = FMath::Clamp(float(-GetDistance(Position) / NoiseScale), 0.f, 1.f);
+    return FLinearColor(Noise, 1.f - Noise, Depth, 1.f);
+}
+
+FVector3f VCET::FSyntheticLayer::GetNormal(const FVector& Position) const
+{
+    // Central differences, small against the noise features
+    const double Step = NoiseScale * 0.001;
+    const FVector Gradient(
+        GetDistance(Position + FVector(Step, 0., 0.)) - GetDistance(Position - FVector(Step, 0., 0.)),
+        GetDistance(Position + FVector(0., Step, 0.)) - GetDistance(Position - FVector(0., Step, 0.)),
+        GetDistance(Position + FVector(0., 0., Step)) - GetDistance(Position - FVector(0., 0., Step)));
+
+    return FVector3f(Gradient.GetSafeNormal(UE_SMALL_NUMBER, FVector::UpVector));
+}
+
+void VCET::FSyntheticLayer::SampleDistance(const FVoxelDoubleVectorBuffer& Positions, TArray<float>& OutValues) const
+{
+    SampleSynthetic(Positions, OutValues, [&](const FVector& Position) { return float(GetDistance(Position)); });
+}
+
+void VCET::FSyntheticLayer::SampleFloat(const FVoxelDoubleVectorBuffer& Positions, TArray<float>& OutValues) const
+{
+    SampleSynthetic(Positions, OutValues, [&](const FVector& Position) { return GetFloat(Position); });
+}
+
+void VCET::FSyntheticLayer::SampleColor(const FVoxelDoubleVectorBuffer& Positions, TArray<FLinearColor>& OutValues) const
+{
+    SampleSynthetic(Positions, OutValues, [&](const FVector& Position) { return GetColor(Position); });
+}
+
+void VCET::FSyntheticLayer::SampleNormal(const FVoxelDoubleVectorBuffer& Positions, TArray<FVector3f>& OutValues) const
+{
+    SampleSynthetic(Positions, OutValues, [&](const FVector& Position) { return GetNormal(Position); });
+}
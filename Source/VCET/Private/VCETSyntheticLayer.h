@@ -0,0 +1,47 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Buffer/VoxelDoubleBuffers.h"
+
+/**
+ * Analytic stand-in for a volume layer, for benchmarks and tests that must run without a voxel world or any content.
+ *
+ * The distance field is the union of a sphere and a box, displaced by fixed Perlin noise. Every metadata type
+ * the bakers support is derived from it, so the same positions always give the same samples on every machine:
+ *   - Float: noise in [-1, 1], at an offset from the displacement
+ *   - LinearColor: a gradient from the noise and the distance
+ *   - Normal: the normalized gradient of the distance field
+ *
+ * Bake through it with VCET::FBakeSource::InitializeSynthetic(). All functions are thread safe.
+ */
+namespace VCET
+{
+    struct FSyntheticLayer
+    {
+        FVector SphereCenter = FVector::ZeroVector;
+        double SphereRadius = 600000.;
+
+        FVector BoxCenter = FVector(0., 0., 600000.);
+        FVector BoxExtent = FVector(20000.);
+
+        /** Displacement of the surface. 0 for the exact SDFs */
+        double NoiseAmplitude = 2000.;
+        /** World size of the noise features */
+        double NoiseScale = 20000.;
+
+        double GetDistance(const FVector& Position) const;
+        float GetFloat(const FVector& Position) const;
+        FLinearColor GetColor(const FVector& Position) const;
+        FVector3f GetNormal(const FVector& Position) const;
+
+        void SampleDistance(const FVoxelDoubleVectorBuffer& Positions, TArray<float>& OutValues) const;
+        void SampleFloat(const FVoxelDoubleVectorBuffer& Positions, TArray<float>& OutValues) const;
+        void SampleColor(const FVoxelDoubleVectorBuffer& Positions, TArray<FLinearColor>& OutValues) const;
+        void SampleNormal(const FVoxelDoubleVectorBuffer& Positions, TArray<FVector3f>& OutValues) const;
+
+    private:
+        double GetNoise(const FVector& Position, const FVector& Offset) const;
+    };
+}
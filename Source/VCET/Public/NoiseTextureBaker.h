@@ -0,0 +1,225 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VCETBakerComponent.h"
+#include "Engine/Texture2D.h"
+#include "Engine/VolumeTexture.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTargetVolume.h"
+#include "VCETProceduralNoiseNodes.h"
+#include "NoiseTextureBaker.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnNoiseTextureBaked);
+
+UENUM(BlueprintType)
+enum class ENoiseTextureBakeMode : uint8
+{
+    /** 2D noise over the XY rectangle of the region, written to a 2D render target */
+    Texture2D,
+    /** 3D noise over the region, written to a volume render target */
+    Volume
+};
+
+/**
+ * Bakes a procedural noise configuration straight to a texture.
+ *
+ * Evaluates the ISPC kernels behind the Procedural Noise 2D/3D nodes over a regular grid,
+ * one row per call on worker threads, without going through a voxel layer, a graph or
+ * FVoxelQuery. Use it to preview a noise, or to ship it as a material texture.
+ *
+ * Features:
+ * - 2D (render target) or 3D (volume render target) output
+ * - Same noise settings as the Procedural Noise nodes (types, octaves, accumulation, fast math)
+ * - Same processing options as the other bakers (remap, normalize, invert, multiplier)
+ * - Optional static UTexture2D/UVolumeTexture asset creation
+ */
+UCLASS(ClassGroup=(VCET), meta=(BlueprintSpawnableComponent), DisplayName="VCET Noise Texture Baker")
+class VCET_API UNoiseTextureBaker : public UVCETBakerComponent
+{
+    GENERATED_BODY()
+
+public:
+    UNoiseTextureBaker();
+
+    // === Noise ===
+
+    /** Texture2D samples 2D noise on a grid over the XY of the region, Volume samples 3D noise over the whole region */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
+    ENoiseTextureBakeMode Mode = ENoiseTextureBakeMode::Texture2D;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (EditCondition = "Mode == ENoiseTextureBakeMode::Texture2D", EditConditionHides))
+    EVoxelProceduralNoiseType2D NoiseType2D = EVoxelProceduralNoiseType2D::Perlin;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (EditCondition = "Mode == ENoiseTextureBakeMode::Volume", EditConditionHides))
+    EVoxelProceduralNoiseType3D NoiseType3D = EVoxelProceduralNoiseType3D::Perlin;
+
+    /** How octaves are combined */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
+    EVoxelProceduralNoiseAccumulation Accumulation = EVoxelProceduralNoiseAccumulation::FBM;
+
+    /** Amount of space the noise will take to tile in the world, a divisor for position */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (ClampMin = "0.001"))
+    float FeatureScale = 25000.0f;
+
+    /** A factor for how much smaller each octave's feature scale is compared to last octave's */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
+    float Lacunarity = 2.0f;
+
+    /** A factor for how much smaller each octave's amplitude is compared to last octave's */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
+    float Gain = 0.5f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (ClampMin = "1", ClampMax = "255"))
+    int32 NumOctaves = 4;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
+    int32 Seed = 1337;
+
+    /** Multiplier for the amplitude of each octave. Octaves past the end of the array use 1 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", AdvancedDisplay)
+    TArray<float> OctaveStrengths;
+
+    /** Edge smoothness of the cell blending when using Voronoi noise */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", AdvancedDisplay)
+    float VoronoiSmoothness = 1.0f;
+
+    /** Phase offset of the wavelets when using Wavelet noise */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", AdvancedDisplay)
+    float WaveletPhase = 0.0f;
+
+    /** Edge smoothness of the lines when using Scratch noise */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", AdvancedDisplay)
+    float ScratchSmoothness = 0.05f;
+
+    /** Use polynomial approximations of pow, exp, sin and cos */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", AdvancedDisplay)
+    bool bFastMath = false;
+
+    // === Region ===
+
+    /** Center of the sampled region (world space) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Region")
+    FVector RegionCenter = FVector::ZeroVector;
+
+    /** Size of the sampled region. Texture2D only uses X and Y */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Region")
+    FVector RegionSize = FVector(100000.0f, 100000.0f, 100000.0f);
+
+    // === Texture ===
+
+    /** External render target (Texture2D mode). Leave null to auto-create. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Texture", meta = (EditCondition = "Mode == ENoiseTextureBakeMode::Texture2D"))
+    TObjectPtr<UTextureRenderTarget2D> RenderTarget;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Texture", meta = (ClampMin = "16", ClampMax = "4096", EditCondition = "Mode == ENoiseTextureBakeMode::Texture2D"))
+    int32 TextureWidth = 512;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Texture", meta = (ClampMin = "16", ClampMax = "4096", EditCondition = "Mode == ENoiseTextureBakeMode::Texture2D"))
+    int32 TextureHeight = 512;
+
+    /** External volume render target (Volume mode), must be cubic. Its size overrides VolumeResolution. Leave null to auto-create. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Texture", meta = (EditCondition = "Mode == ENoiseTextureBakeMode::Volume"))
+    TObjectPtr<UTextureRenderTargetVolume> VolumeRenderTarget;
+
+    /** Volume texture resolution (cubic grid: N*N*N voxels). Memory usage: N^3 * 8 bytes */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Texture", meta = (ClampMin = "4", ClampMax = "256", EditCondition = "Mode == ENoiseTextureBakeMode::Volume"))
+    int32 VolumeResolution = 128;
+
+    // === Processing ===
+
+    /** Remap values from (-1,1) to (0,1) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing")
+    bool bRemapNegativeToPositive = true;
+
+    /** Auto-normalize values to 0-1 range */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing")
+    bool bAutoNormalize = false;
+
+    /** Invert the result (1 - value) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing")
+    bool bInvertResult = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing", meta = (ClampMin = "0.01", ClampMax = "100.0"))
+    float ResultMultiplier = 1.0f;
+
+    /** Auto-created 2D render targets use RGBA16f instead of RGBA8 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing")
+    bool bUseHDR = false;
+
+    // === Lifecycle ===
+
+    /** Bake on BeginPlay */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Lifecycle")
+    bool bBakeOnBeginPlay = false;
+
+    // === Asset Creation ===
+
+    /** Automatically create a static UTexture2D/UVolumeTexture asset after baking completes */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Creation")
+    bool bCreateStaticAsset = false;
+
+    /** Package path where the static texture asset will be saved */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Creation", meta = (EditCondition = "bCreateStaticAsset"))
+    FString AssetOutputPath = TEXT("/Game/VCET/Noise");
+
+    /** Base name for the created asset. Numbers are appended to avoid overwrites */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Creation", meta = (EditCondition = "bCreateStaticAsset"))
+    FString AssetBaseName = TEXT("NoiseTexture");
+
+    // === Output ===
+
+    UPROPERTY(BlueprintReadOnly, Category = "Output")
+    TObjectPtr<UTextureRenderTarget2D> Texture;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Output")
+    TObjectPtr<UTextureRenderTargetVolume> VolumeTexture;
+
+    /** The last created static asset (if bCreateStaticAsset is enabled): a UTexture2D or a UVolumeTexture */
+    UPROPERTY(BlueprintReadOnly, Category = "Output")
+    TObjectPtr<UTexture> StaticTexture;
+
+    UPROPERTY(BlueprintAssignable, Category = "Events")
+    FOnNoiseTextureBaked OnBakeComplete;
+
+    // === Functions ===
+
+    UFUNCTION(BlueprintCallable, Category = "VCET|Noise Texture")
+    void ForceRebake();
+
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Noise Texture")
+    UTextureRenderTarget2D* GetTexture() const { return Texture; }
+
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Noise Texture")
+    UTextureRenderTargetVolume* GetVolumeTexture() const { return VolumeTexture; }
+
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Noise Texture")
+    bool IsBaking() const { return bIsBaking; }
+
+    /** Manually create a static texture asset from the last bake */
+    UFUNCTION(BlueprintCallable, Category = "VCET|Noise Texture")
+    UTexture* CreateStaticTexture();
+
+    UFUNCTION(BlueprintCallable, Category = "VCET|Noise Texture", meta = (WorldContext = "WorldContextObject"))
+    static void RequestGlobalRebake(UObject* WorldContextObject);
+
+    //~ Begin UVCETBakerComponent Interface
+    virtual void StartBake() override { ForceRebake(); }
+    virtual bool IsBakeInProgress() const override { return IsBaking(); }
+    virtual TArray<UTexture*> SaveBakedTextures(bool bReplaceExisting) override;
+    //~ End UVCETBakerComponent Interface
+
+protected:
+    virtual void BeginPlay() override;
+
+private:
+    bool bIsBaking = false;
+
+    // Mode of the last bake, whose colors are cached (used for creating static textures)
+    ENoiseTextureBakeMode CachedMode = ENoiseTextureBakeMode::Texture2D;
+
+    void CreateRT();
+    void BakeNoise();
+    UTexture* CreateStaticTextureImpl(bool bReplaceExisting);
+};
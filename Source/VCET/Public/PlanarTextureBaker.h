@@ -3,10 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Components/ActorComponent.h"
+#include "VCETBakerComponent.h"
+#include "Engine/Texture2D.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "VoxelMinimal.h"
 #include "VoxelStackLayer.h"
+#include "VCETChannelPacking.h"
 #include "VoxelQueryBlueprintLibrary.h"
 #include "PlanarTextureBaker.generated.h"
 
@@ -30,7 +32,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnPlanarTextureBaked);
  * - External or auto-created render targets
  */
 UCLASS(ClassGroup=(VCET), meta=(BlueprintSpawnableComponent), DisplayName="VCET Planar Texture Baker")
-class VCET_API UPlanarTextureBaker : public UActorComponent
+class VCET_API UPlanarTextureBaker : public UVCETBakerComponent
 {
     GENERATED_BODY()
 
@@ -42,6 +44,17 @@ public:
     /** The Voxel VOLUME layer to query */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
     FVoxelStackVolumeLayer VolumeLayer;
+    
+    /** 
+     * Query the LOD matching the texel size (see Project Settings > Plugins > VCET > Query LOD Voxel Size),
+     * so coarse bakes don't evaluate graph detail they can't resolve. Disable to use QueryLOD
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
+    bool bAutoQueryLOD = true;
+    
+    /** LOD of the queries when bAutoQueryLOD is disabled. 0 is full detail */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel", meta = (ClampMin = "0", ClampMax = "24", EditCondition = "!bAutoQueryLOD"))
+    int32 QueryLOD = 0;
 
     // === Shared ===
     
@@ -71,6 +84,10 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Primary Layer", meta = (EditCondition = "bEnablePrimaryLayer"))
     TObjectPtr<UVoxelMetadata> PrimaryMetadata;
     
+    /** Packs up to four sources into the RGBA channels instead of sampling PrimaryMetadata, all in one query */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Primary Layer", meta = (EditCondition = "bEnablePrimaryLayer"))
+    FVCETChannelPacking PrimaryChannels;
+    
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Primary Layer", meta = (EditCondition = "bEnablePrimaryLayer"))
     TObjectPtr<UTextureRenderTarget2D> PrimaryRenderTarget;
     
@@ -103,6 +120,10 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Secondary Layer", meta = (EditCondition = "bEnableSecondaryLayer"))
     TObjectPtr<UVoxelMetadata> SecondaryMetadata;
     
+    /** Packs up to four sources into the RGBA channels instead of sampling SecondaryMetadata, all in one query */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Secondary Layer", meta = (EditCondition = "bEnableSecondaryLayer"))
+    FVCETChannelPacking SecondaryChannels;
+    
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Secondary Layer", meta = (EditCondition = "bEnableSecondaryLayer"))
     TObjectPtr<UTextureRenderTarget2D> SecondaryRenderTarget;
     
@@ -138,6 +159,16 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing")
     bool bUseHDR = false;
 
+    // === Asset Creation ===
+    
+    /** Package path where CreateStaticTextures() saves the static texture assets */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Creation")
+    FString AssetOutputPath = TEXT("/Game/VCET/Planar");
+    
+    /** Base name for the created assets, suffixed with the layer name ("_Primary", "_Secondary"). Numbers are appended to avoid overwrites */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Creation")
+    FString AssetBaseName = TEXT("PlanarTexture");
+
     // === Functions ===
     
     UFUNCTION(BlueprintCallable, Category = "VCET|Planar Texture")
@@ -160,6 +191,16 @@ public:
     
     UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Planar Texture")
     bool IsBaking() const { return bIsBakingPrimary || bIsBakingSecondary; }
+    
+    /** Save the last bake of each layer as a static UTexture2D asset (editor only) */
+    UFUNCTION(BlueprintCallable, Category = "VCET|Planar Texture")
+    TArray<UTexture2D*> CreateStaticTextures();
+
+    //~ Begin UVCETBakerComponent Interface
+    virtual void StartBake() override { ForceRebake(); }
+    virtual bool IsBakeInProgress() const override { return IsBaking(); }
+    virtual TArray<UTexture*> SaveBakedTextures(bool bReplaceExisting) override;
+    //~ End UVCETBakerComponent Interface
 
 protected:
     virtual void BeginPlay() override;
@@ -169,7 +210,8 @@ private:
     bool bIsBakingSecondary = false;
     
     void CreateRT(TObjectPtr<UTextureRenderTarget2D>& Out, UTextureRenderTarget2D* External, int32 W, int32 H);
-    void BakeLayer(bool bPrimary, UVoxelMetadata* Meta, UTextureRenderTarget2D* RT, float Z, int32 W, int32 H);
+    void BakeLayer(bool bPrimary, UVoxelMetadata* Meta, const FVCETChannelPacking& Channels, UTextureRenderTarget2D* RT, float Z, int32 W, int32 H);
     void WriteGrayscale(UTextureRenderTarget2D* RT, const TArray<float>& V, int32 W, int32 H);
-    void WriteColor(UTextureRenderTarget2D* RT, const TArray<FLinearColor>& C, int32 W, int32 H);
+    void WriteColor(UTextureRenderTarget2D* RT, const TArray<FLinearColor>& C, int32 W, int32 H, FVCETBakeTelemetry* Telemetry = nullptr);
+    TArray<UTexture2D*> CreateStaticTexturesImpl(bool bReplaceExisting);
 };
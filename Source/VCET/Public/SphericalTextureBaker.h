@@ -3,10 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Components/ActorComponent.h"
+#include "VCETBakerComponent.h"
+#include "Engine/Texture2D.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "VoxelMinimal.h"
 #include "VoxelStackLayer.h"
+#include "VCETChannelPacking.h"
 #include "VoxelQueryBlueprintLibrary.h"
 #include "SphericalTextureBaker.generated.h"
 
@@ -14,8 +16,17 @@ class UVoxelMetadata;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSphericalTextureBaked);
 
+UENUM(BlueprintType)
+enum class ESphericalBakeProjection : uint8
+{
+    /** Longitude along X, latitude along Y. Texels bunch up at the poles */
+    Equirectangular,
+    /** Six square cube faces side by side (+X, -X, +Y, -Y, +Z, -Z), each Height x Height. Near-uniform texel density */
+    CubeStrip
+};
+
 /**
- * Bakes Voxel VOLUME layer data to equirectangular render targets.
+ * Bakes Voxel VOLUME layer data to equirectangular or cube strip render targets.
  * Samples 3D positions on a sphere surface and writes to 2D textures.
  * 
  * Use for planetary/spherical worlds to bake clouds, terrain colors, etc.
@@ -29,7 +40,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSphericalTextureBaked);
  * - External or auto-created render targets
  */
 UCLASS(ClassGroup=(VCET), meta=(BlueprintSpawnableComponent), DisplayName="VCET Spherical Texture Baker")
-class VCET_API USphericalTextureBaker : public UActorComponent
+class VCET_API USphericalTextureBaker : public UVCETBakerComponent
 {
     GENERATED_BODY()
 
@@ -41,6 +52,17 @@ public:
     /** The Voxel VOLUME layer to query */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
     FVoxelStackVolumeLayer VolumeLayer;
+    
+    /** 
+     * Query the LOD matching the texel size (see Project Settings > Plugins > VCET > Query LOD Voxel Size),
+     * so coarse bakes don't evaluate graph detail they can't resolve. Disable to use QueryLOD
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
+    bool bAutoQueryLOD = true;
+    
+    /** LOD of the queries when bAutoQueryLOD is disabled. 0 is full detail */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel", meta = (ClampMin = "0", ClampMax = "24", EditCondition = "!bAutoQueryLOD"))
+    int32 QueryLOD = 0;
 
     // === Shared ===
     
@@ -48,6 +70,10 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shared")
     FVector SphereCenter = FVector::ZeroVector;
     
+    /** How the sphere is unwrapped. Auto-created cube strip targets ignore the texture width and use 6 * height */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shared")
+    ESphericalBakeProjection Projection = ESphericalBakeProjection::Equirectangular;
+    
     /** Bake on BeginPlay */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Shared")
     bool bBakeOnBeginPlay = false;
@@ -66,6 +92,10 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cloud Layer", meta = (EditCondition = "bEnableCloudLayer"))
     TObjectPtr<UVoxelMetadata> CloudMetadata;
     
+    /** Packs up to four sources into the RGBA channels instead of sampling CloudMetadata, all in one query */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cloud Layer", meta = (EditCondition = "bEnableCloudLayer"))
+    FVCETChannelPacking CloudChannels;
+    
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cloud Layer", meta = (EditCondition = "bEnableCloudLayer"))
     TObjectPtr<UTextureRenderTarget2D> CloudRenderTarget;
     
@@ -98,6 +128,10 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Land Layer", meta = (EditCondition = "bEnableLandLayer"))
     TObjectPtr<UVoxelMetadata> LandMetadata;
     
+    /** Packs up to four sources into the RGBA channels instead of sampling LandMetadata, all in one query */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Land Layer", meta = (EditCondition = "bEnableLandLayer"))
+    FVCETChannelPacking LandChannels;
+    
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Land Layer", meta = (EditCondition = "bEnableLandLayer"))
     TObjectPtr<UTextureRenderTarget2D> LandRenderTarget;
     
@@ -133,6 +167,16 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing")
     bool bUseHDR = false;
 
+    // === Asset Creation ===
+    
+    /** Package path where CreateStaticTextures() saves the static texture assets */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Creation")
+    FString AssetOutputPath = TEXT("/Game/VCET/Spherical");
+    
+    /** Base name for the created assets, suffixed with the layer name ("_Cloud", "_Land"). Numbers are appended to avoid overwrites */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Asset Creation")
+    FString AssetBaseName = TEXT("SphericalTexture");
+
     // === Functions ===
     
     UFUNCTION(BlueprintCallable, Category = "VCET|Spherical Texture")
@@ -155,6 +199,16 @@ public:
     
     UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Spherical Texture")
     bool IsBaking() const { return bIsBakingCloud || bIsBakingLand; }
+    
+    /** Save the last bake of each layer as a static UTexture2D asset (editor only) */
+    UFUNCTION(BlueprintCallable, Category = "VCET|Spherical Texture")
+    TArray<UTexture2D*> CreateStaticTextures();
+
+    //~ Begin UVCETBakerComponent Interface
+    virtual void StartBake() override { ForceRebake(); }
+    virtual bool IsBakeInProgress() const override { return IsBaking(); }
+    virtual TArray<UTexture*> SaveBakedTextures(bool bReplaceExisting) override;
+    //~ End UVCETBakerComponent Interface
 
 protected:
     virtual void BeginPlay() override;
@@ -163,8 +217,10 @@ private:
     bool bIsBakingCloud = false;
     bool bIsBakingLand = false;
     
+    int32 GetProjectedWidth(int32 W, int32 H) const { return Projection == ESphericalBakeProjection::CubeStrip ? 6 * H : W; }
     void CreateRT(TObjectPtr<UTextureRenderTarget2D>& Out, UTextureRenderTarget2D* External, int32 W, int32 H);
-    void BakeLayer(bool bCloud, UVoxelMetadata* Meta, UTextureRenderTarget2D* RT, float R, int32 W, int32 H);
+    void BakeLayer(bool bCloud, UVoxelMetadata* Meta, const FVCETChannelPacking& Channels, UTextureRenderTarget2D* RT, float R, int32 W, int32 H);
     void WriteGrayscale(UTextureRenderTarget2D* RT, const TArray<float>& V, int32 W, int32 H);
-    void WriteColor(UTextureRenderTarget2D* RT, const TArray<FLinearColor>& C, int32 W, int32 H);
+    void WriteColor(UTextureRenderTarget2D* RT, const TArray<FLinearColor>& C, int32 W, int32 H, FVCETBakeTelemetry* Telemetry = nullptr);
+    TArray<UTexture2D*> CreateStaticTexturesImpl(bool bReplaceExisting);
 };
@@ -0,0 +1,47 @@
+// Copyright Zundle. MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VCETBakeBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures the throughput of the bake engine for every baker mapping.
+ *
+ * Runs the bake of each mapping (planar, equirect, cube, volume, shell) at several resolutions
+ * against the analytic layer of VCETSyntheticLayer.h through VCET::RunBakeJobs(), the code path of
+ * the bakers, then converts the colors to the render target format and uploads them (skipped when
+ * the app can't render). Writes one CSV row per case with the wall time of each stage, the CPU time
+ * of the worker phases from the bake telemetry (positions, query, processing), samples/sec and the
+ * peak memory of the bake. -Coalesce=N runs N bakes of each case together, sharing their queries as
+ * coalesced bakes do, and suffixes the keys with _xN. -Metadata=Float|Color|Normal samples that metadata instead of the distance,
+ * and -Metadata=Packed packs the distance, float, color and normal into the RGBA channels in one pass.
+ * -SampleOrders=Linear,Bricks,Morton runs every case in each sample order (see vcet.Bake.SampleOrder)
+ * instead of Linear only, suffixing the keys of the brick orders. The default ignores vcet.Bake.SampleOrder
+ * so that keys match baselines whatever the project's sample order is.
+ *
+ * With -Baseline, compares samples/sec against a previous CSV and returns a non-zero exit code
+ * if any case got slower by more than -Threshold, so it can gate CI. Cases missing from the baseline
+ * are logged as warnings, and a baseline matching no case fails.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd Project.uproject -run=VCETBakeBenchmark
+ *     [-Bakers=Planar,Equirect,Cube,Volume,Shell] [-Sizes=256,512,1024] [-VolumeSizes=32,64,128]
+ *     [-Metadata=Distance] [-SampleOrders=Linear,Morton] [-Coalesce=1] [-Iterations=3]
+ *     [-Baseline=Path/To/Baseline.csv] [-Threshold=0.1] [-Output=Path/To/Result.csv]
+ *
+ * Without -Output, results are written to Saved/VCET/Benchmarks/.
+ */
+UCLASS()
+class UVCETBakeBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UVCETBakeBenchmarkCommandlet();
+
+    //~ Begin UCommandlet Interface
+    virtual int32 Main(const FString& Params) override;
+    //~ End UCommandlet Interface
+};
@@ -0,0 +1,41 @@
+// Copyright Zundle. MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VCETBakeCommandlet.generated.h"
+
+/**
+ * Bakes every VCET baker of a list of maps offline and saves the results as static textures.
+ *
+ * Loads each map without rendering, finds all the VCET baker components in its loaded levels,
+ * and runs up to -Workers bakes at once (each bake is itself split across the task graph by
+ * the bake engine). Every baker's results are saved with its AssetOutputPath/AssetBaseName.
+ * Logs the time taken by each baker and writes them to a CSV report.
+ *
+ * Returns a non-zero exit code if a map fails to load, a baker fails to start, times out
+ * or produces nothing to save, so build machines can run it unattended.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd Project.uproject -run=VCETBake -Maps=/Game/Maps/A,/Game/Maps/B
+ *     [-Workers=2] [-Timeout=600] [-DrainTimeout=60] [-Overwrite] [-NoSave] [-Report=Path/To/Report.csv] -nullrhi
+ *
+ * -Overwrite saves each asset under its base name, replacing the previous bake, instead of numbering it.
+ * -Timeout is in seconds per bake, counted from its launch rather than from the map's load. A timed out bake still
+ * runs: the map is only unloaded once every bake finished, waiting at most -DrainTimeout seconds, and stays loaded
+ * past that rather than being destroyed under the bakes.
+ * Without -Report, the report is written to Saved/VCET/Bakes/.
+ */
+UCLASS()
+class UVCETBakeCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UVCETBakeCommandlet();
+
+    //~ Begin UCommandlet Interface
+    virtual int32 Main(const FString& Params) override;
+    //~ End UCommandlet Interface
+};
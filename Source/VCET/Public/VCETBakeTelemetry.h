@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VCETBakeTelemetry.generated.h"
+
+/**
+ * Timings and sizes of one bake, recorded by every baker when its bake completes.
+ *
+ * Worker phases (positions, query, metadata copy, post-processing) are summed over the chunks baked in parallel,
+ * so they are CPU time and can add up to more than TotalMs. Queue wait, game thread and total are wall time.
+ */
+USTRUCT(BlueprintType)
+struct VCET_API FVCETBakeTelemetry
+{
+    GENERATED_BODY()
+
+    /** Owner label and component name of the baker */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FString Baker;
+
+    /** Which output of the baker (e.g. Primary, Cloud, Volume) */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FString Output;
+
+    /** UTC time the bake completed */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FDateTime Timestamp;
+
+    /** From the bake request to a worker picking it up: the waits for the memory budget, for coalescing and for a worker */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float QueueWaitMs = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float PositionsMs = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float QueryMs = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float MetadataCopyMs = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float PostProcessMs = 0.f;
+
+    /** Conversion of the colors to the render target format */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float ConversionMs = 0.f;
+
+    /** From the worker finishing to the game thread completing the bake, conversion and upload requests included */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float GameThreadMs = 0.f;
+
+    /** From the bake request to its completion on the game thread */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float TotalMs = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int64 NumSamples = 0;
+
+    /** Samples left transparent black because the metadata buffer didn't cover them or the metadata was invalid */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int64 NumSkippedSamples = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int64 BytesUploaded = 0;
+
+    /** Estimated peak of the memory held by the bake: samples, colors, in-flight chunks and converted pixels */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int64 PeakMemoryBytes = 0;
+
+    /** LOD the volume layer was queried at */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int32 QueryLOD = 0;
+
+    /** Bakes run together with this one to share their queries, itself included (see vcet.Bake.Coalesce) */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int32 NumCoalescedBakes = 1;
+
+    /** FPlatformTime::Seconds() of the bake request and of the worker finishing, to complete the wall times */
+    double LaunchTime = 0.;
+    double AsyncEndTime = 0.;
+};
+
+USTRUCT(BlueprintType)
+struct VCET_API FVCETBakePercentiles
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float P50 = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float P90 = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float P99 = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float Max = 0.f;
+};
+
+USTRUCT(BlueprintType)
+struct VCET_API FVCETBakeTelemetrySummary
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int32 NumBakes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FVCETBakePercentiles TotalMs;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FVCETBakePercentiles QueueWaitMs;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FVCETBakePercentiles QueryMs;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    FVCETBakePercentiles GameThreadMs;
+
+    /** Samples of all the bakes over their summed total time */
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    float SamplesPerSecond = 0.f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int64 NumSkippedSamples = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int64 BytesUploaded = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Telemetry")
+    int64 PeakMemoryBytes = 0;
+
+    static FVCETBakeTelemetrySummary Compute(TConstArrayView<FVCETBakeTelemetry> Records);
+};
+
+/**
+ * Keeps the telemetry of the last bakes of every baker in the world (vcet.Bake.Telemetry.WorldHistorySize),
+ * and appends each record to the CSV file set in vcet.Bake.Telemetry.Csv, if any.
+ */
+UCLASS()
+class VCET_API UVCETBakeTelemetrySubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    void RecordBake(const FVCETBakeTelemetry& Telemetry);
+
+    /** Oldest first */
+    UFUNCTION(BlueprintPure, Category = "VCET|Telemetry")
+    const TArray<FVCETBakeTelemetry>& GetBakeHistory() const { return History; }
+
+    UFUNCTION(BlueprintPure, Category = "VCET|Telemetry")
+    FVCETBakeTelemetrySummary GetBakeSummary() const;
+
+    UFUNCTION(BlueprintCallable, Category = "VCET|Telemetry")
+    void ClearBakeHistory();
+
+private:
+    TArray<FVCETBakeTelemetry> History;
+};
+
+namespace VCET
+{
+    /** Adds Record to History, dropping the oldest records past MaxNum */
+    VCET_API void AddBoundedBakeTelemetry(TArray<FVCETBakeTelemetry>& History, const FVCETBakeTelemetry& Record, int32 MaxNum);
+    /** Field quoted, with quotes doubled (RFC 4180), for CSV fields that may contain commas and quotes such as names */
+    VCET_API FString EscapeCsvField(const FString& Field);
+}
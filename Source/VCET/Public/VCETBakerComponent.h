@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "VCETBakeTelemetry.h"
+#include "VCETBakerComponent.generated.h"
+
+class UTexture;
+
+namespace VCET
+{
+    class FBakeMemoryBudget;
+}
+
+/** Colors of one baker output, kept to create its static texture. Evictable by the VCET memory budget */
+struct FVCETBakeCache
+{
+    TArray<FLinearColor> Colors;
+    /** Texels along X, Y and Z, Z being 1 for 2D outputs */
+    FIntVector Size = FIntVector::ZeroValue;
+    /** Set while the colors are spilled to disk */
+    FString SpillPath;
+    /** FPlatformTime::Seconds() of the last bake or read, for the LRU eviction */
+    double LastUseTime = 0.;
+};
+
+/**
+ * Base class of the VCET baker components.
+ *
+ * Gives tools that don't know the concrete baker types (the VCETBake commandlet) a way to
+ * start a bake, wait for it and save its results. Each baker keeps its own Blueprint API.
+ *
+ * Also owns the cached colors of the bakers and registers them with the VCET memory budget (see VCETBakeMemory.h).
+ */
+UCLASS(Abstract, ClassGroup=(VCET))
+class VCET_API UVCETBakerComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    /** Starts every bake this component is configured for, like ForceRebake() */
+    virtual void StartBake() PURE_VIRTUAL(UVCETBakerComponent::StartBake, );
+
+    /** Whether any bake of this component is still running */
+    virtual bool IsBakeInProgress() const PURE_VIRTUAL(UVCETBakerComponent::IsBakeInProgress, return false;);
+
+    /**
+     * Saves the results of the last bake as static texture assets (editor only).
+     * With bReplaceExisting, assets are saved under their base name, overwriting previous ones, instead of getting a numbered name.
+     * Returns the created textures, empty if there is nothing baked
+     */
+    virtual TArray<UTexture*> SaveBakedTextures(bool bReplaceExisting) PURE_VIRTUAL(UVCETBakerComponent::SaveBakedTextures, return {};);
+
+    /** Owner label and component name, for logs */
+    FString GetBakerName() const;
+
+    /** Telemetry of the last bakes of this component (vcet.Bake.Telemetry.HistorySize), oldest first */
+    UFUNCTION(BlueprintPure, Category = "VCET|Telemetry")
+    const TArray<FVCETBakeTelemetry>& GetBakeTelemetryHistory() const { return TelemetryHistory; }
+
+    /** Percentiles over GetBakeTelemetryHistory() */
+    UFUNCTION(BlueprintPure, Category = "VCET|Telemetry")
+    FVCETBakeTelemetrySummary GetBakeTelemetrySummary() const;
+
+    /** Resident cached colors of all outputs, spilled ones excluded */
+    int64 GetCachedColorsBytes() const;
+    /** Render targets this component created, external ones excluded */
+    int64 GetRenderTargetBytes() const;
+
+    //~ Begin UActorComponent Interface
+    virtual void OnRegister() override;
+    virtual void OnUnregister() override;
+    //~ End UActorComponent Interface
+
+    //~ Begin UObject Interface
+    virtual void BeginDestroy() override;
+    //~ End UObject Interface
+
+protected:
+    /**
+     * Completes the telemetry of a bake with its game thread time, then records it in this component's history
+     * and in the world's UVCETBakeTelemetrySubsystem. Call once the bake's completion is done on the game thread
+     */
+    void RecordBakeTelemetry(FVCETBakeTelemetry Telemetry, const FString& Output);
+
+    /** Keeps the colors of the last bake of Output, for its static texture */
+    void SetCachedColors(FName Output, const TArray<FLinearColor>& Colors, const FIntVector& Size);
+    /**
+     * Cached colors of Output, reloaded from disk if they were spilled.
+     * Null if Output was never baked, or its colors were dropped to stay within the memory budget
+     */
+    const FVCETBakeCache* FindCachedColors(FName Output);
+
+private:
+    TArray<FVCETBakeTelemetry> TelemetryHistory;
+    TMap<FName, FVCETBakeCache> CachedColors;
+
+    /** Spills or drops the resident colors of Output. Returns the bytes freed */
+    int64 EvictCachedColors(FName Output, bool bSpill);
+
+    friend class VCET::FBakeMemoryBudget;
+};
@@ -0,0 +1,112 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelMinimal.h"
+#include "VoxelStackLayer.h"
+#include "VCETChannelPacking.generated.h"
+
+class UVoxelMetadata;
+
+UENUM(BlueprintType)
+enum class EVCETChannelSourceType : uint8
+{
+    /** Constant DefaultValue */
+    None,
+    /** Distance field of the layer */
+    Distance,
+    /** Float metadata, or one component of color or normal metadata */
+    Metadata
+};
+
+UENUM(BlueprintType)
+enum class EVCETChannelComponent : uint8
+{
+    R UMETA(DisplayName = "R / X"),
+    G UMETA(DisplayName = "G / Y"),
+    B UMETA(DisplayName = "B / Z"),
+    A
+};
+
+/** What one channel of a packed texture samples, and how its values are remapped */
+USTRUCT(BlueprintType)
+struct VCET_API FVCETChannelSource
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channel")
+    EVCETChannelSourceType Type = EVCETChannelSourceType::None;
+
+    /** Layer to sample. Leave unset to sample the baker's layer */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channel", meta = (EditCondition = "Type != EVCETChannelSourceType::None"))
+    FVoxelStackVolumeLayer Layer;
+
+    /** Float, linear color or normal metadata */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channel", meta = (EditCondition = "Type == EVCETChannelSourceType::Metadata"))
+    TObjectPtr<UVoxelMetadata> Metadata;
+
+    /** Component of color or normal metadata. Ignored for float metadata */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channel", meta = (EditCondition = "Type == EVCETChannelSourceType::Metadata"))
+    EVCETChannelComponent Component = EVCETChannelComponent::R;
+
+    /** Sampled values from InputMin to InputMax are mapped to OutputMin to OutputMax */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Remap", meta = (EditCondition = "Type != EVCETChannelSourceType::None"))
+    float InputMin = 0.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Remap", meta = (EditCondition = "Type != EVCETChannelSourceType::None"))
+    float InputMax = 1.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Remap", meta = (EditCondition = "Type != EVCETChannelSourceType::None"))
+    float OutputMin = 0.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Remap", meta = (EditCondition = "Type != EVCETChannelSourceType::None"))
+    float OutputMax = 1.f;
+
+    /** Clamp the remapped values between OutputMin and OutputMax */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Remap", meta = (EditCondition = "Type != EVCETChannelSourceType::None"))
+    bool bClamp = true;
+
+    /** Value of the channel when it has no source, or where its metadata wasn't sampled */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Remap")
+    float DefaultValue = 0.f;
+};
+
+/**
+ * Packs up to four sources into the RGBA channels of one texture, e.g. density, temperature, wetness and distance.
+ *
+ * All the channels are resolved in a single query over a single set of positions: the metadata of each layer is
+ * sampled in one SampleVolumeLayer call, whatever the number of channels using it. Replaces the metadata and the
+ * processing options of the baker (remap, normalize, invert, multiplier): each channel has its own remap.
+ */
+USTRUCT(BlueprintType)
+struct VCET_API FVCETChannelPacking
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channels")
+    bool bEnabled = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channels", meta = (EditCondition = "bEnabled"))
+    FVCETChannelSource R;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channels", meta = (EditCondition = "bEnabled"))
+    FVCETChannelSource G;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channels", meta = (EditCondition = "bEnabled"))
+    FVCETChannelSource B;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Channels", meta = (EditCondition = "bEnabled"))
+    FVCETChannelSource A;
+
+    FVCETChannelPacking()
+    {
+        A.DefaultValue = 1.f;
+    }
+
+    const FVCETChannelSource& GetChannel(int32 Index) const
+    {
+        check(Index >= 0 && Index < 4);
+        return Index == 0 ? R : Index == 1 ? G : Index == 2 ? B : A;
+    }
+};
@@ -0,0 +1,36 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VCETColumnReduction.generated.h"
+
+/**
+ * One vertical column of a volume bake reduced to 2D map values (see UVolumeTextureBaker::bComputeColumnReductions).
+ * Densities are the processed values of the baked texture. Heights are world Z for box regions, and radii from the
+ * center for spherical regions, at the sample centers
+ */
+USTRUCT(BlueprintType)
+struct VCET_API FVCETColumnReduction
+{
+    GENERATED_BODY()
+
+    /** Fraction of the column's samples denser than the threshold */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column")
+    float Coverage = 0.f;
+
+    /** Density integrated over the height of the column, in density x world units */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column")
+    float IntegratedDensity = 0.f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column")
+    float MaxDensity = 0.f;
+
+    /** Height of the lowest sample denser than the threshold. 0 if Coverage is 0 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column")
+    float CloudBase = 0.f;
+
+    /** Height of the highest sample denser than the threshold. 0 if Coverage is 0 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column")
+    float CloudTop = 0.f;
+};
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+VCET_API DECLARE_LOG_CATEGORY_EXTERN(LogVCET, Log, All);
+
 class FVCETModule : public IModuleInterface
 {
 public:
@@ -0,0 +1,37 @@
+// Copyright Zundle. MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VCETNoiseAccuracyCommandlet.generated.h"
+
+/**
+ * Bounds the error introduced by the FastMath pin of the procedural noise nodes.
+ *
+ * 1. Compares each fast math approximation (sin, cos, exp, log2, pow) against the C++ standard library
+ *    over the argument ranges the noises actually use. Each has its own bound, a few times its expected
+ *    max error, that -MaxPrimitiveError overrides for all of them.
+ * 2. Evaluates every noise type with FastMath off and on over the same deterministic positions,
+ *    and reports the max and mean deviation of the fast path (Amplitude = 1, so errors are
+ *    relative to the [-1, 1] output range).
+ *
+ * Returns a non-zero exit code if a primitive exceeds its bound or a noise deviates by more than -MaxError, so it can gate CI. The default is
+ * VCET::ProceduralNoiseFastMathMaxError, which the value range query of the noise nodes also pads its bounds with.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd Project.uproject -run=VCETNoiseAccuracy
+ *     [-MaxError=0.02] [-MaxPrimitiveError=1e-3] [-Octaves=4] [-Num=65536] [-Output=Path/To/Result.csv]
+ */
+UCLASS()
+class UVCETNoiseAccuracyCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UVCETNoiseAccuracyCommandlet();
+
+    //~ Begin UCommandlet Interface
+    virtual int32 Main(const FString& Params) override;
+    //~ End UCommandlet Interface
+};
@@ -0,0 +1,35 @@
+// Copyright Zundle. MIT License.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VCETNoiseBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures the throughput of every procedural noise type.
+ *
+ * Runs the ISPC kernels behind the Procedural Noise 2D/3D nodes over fixed, deterministic
+ * position sets for every noise type, octave count and buffer size. Writes one CSV row per
+ * combination with samples/sec and ns/sample, tagged with the ISPC target dispatched on this
+ * machine so results from different CPUs can be compared side by side.
+ *
+ * Usage:
+ *   UnrealEditor-Cmd Project.uproject -run=VCETNoiseBenchmark
+ *     [-Dimensions=2,3] [-Types=Perlin,Erosion] [-Octaves=1,4,10]
+ *     [-Sizes=1024,32768,262144] [-MinTime=0.25] [-FastMath] [-Parallel] [-Output=Path/To/Result.csv]
+ *
+ * Without -Output, results are written to Saved/VCET/Benchmarks/.
+ */
+UCLASS()
+class UVCETNoiseBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UVCETNoiseBenchmarkCommandlet();
+
+    //~ Begin UCommandlet Interface
+    virtual int32 Main(const FString& Params) override;
+    //~ End UCommandlet Interface
+};
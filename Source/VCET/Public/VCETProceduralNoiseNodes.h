@@ -59,6 +59,36 @@ enum class EVoxelProceduralNoiseType3D : uint8
 	InterleavedGradient = 16 UMETA(ToolTip = "Interleaved gradient noise, a fast dither-style noise"),
 };
 
+// How the octaves of the procedural noise nodes are combined
+UENUM(BlueprintType, DisplayName = "Procedural Noise Accumulation")
+enum class EVoxelProceduralNoiseAccumulation : uint8
+{
+	FBM UMETA(DisplayName = "fBm", ToolTip = "Fractional Brownian motion: plain weighted sum of the octaves"),
+	Ridged UMETA(ToolTip = "Sharp ridges from inverted absolute noise, each octave weighted by the previous one so that detail concentrates on the ridges"),
+	Billow UMETA(ToolTip = "Rounded bumps and creases from absolute noise"),
+	HybridMultifractal UMETA(ToolTip = "Each octave weighted by the previous one: rough peaks and smooth valleys"),
+};
+
+// Ranges of the inputs of a procedural noise node over a region, used to bound its output
+// Position, FeatureScale, Lacunarity, Seed and the noise type parameters don't affect the bounds
+template<typename NoiseType>
+struct TVCETProceduralNoiseRangeInputs
+{
+	// Range of the Amplitude pin over the region
+	FFloatInterval Amplitude = FFloatInterval(10000.f, 10000.f);
+	// Range of the Gain pin over the region
+	FFloatInterval Gain = FFloatInterval(0.5f, 0.5f);
+	int32 NumOctaves = 10;
+	EVoxelProceduralNoiseAccumulation Accumulation = EVoxelProceduralNoiseAccumulation::FBM;
+	NoiseType DefaultNoiseType = NoiseType::Perlin;
+	// Value of the OctaveType pins, octaves without an entry use DefaultNoiseType
+	TArray<NoiseType> OctaveTypes;
+	// Range of the OctaveStrength pins over the region, octaves without an entry use 1
+	TArray<FFloatInterval> OctaveStrengths;
+};
+using FVCETProceduralNoiseRangeInputs2D = TVCETProceduralNoiseRangeInputs<EVoxelProceduralNoiseType2D>;
+using FVCETProceduralNoiseRangeInputs3D = TVCETProceduralNoiseRangeInputs<EVoxelProceduralNoiseType3D>;
+
 // Generates multi-octave height noise from a collection of stylized procedural noises
 USTRUCT(Category = "Noise")
 struct VCET_API FVoxelNode_ProceduralNoise2D : public FVoxelNode
@@ -69,6 +99,9 @@ struct VCET_API FVoxelNode_ProceduralNoise2D : public FVoxelNode
 public:
 	// Position at which to calculate output noise
 	VOXEL_INPUT_PIN(FVoxelVector2DBuffer, Position, nullptr, PositionPin);
+	// Samples where Mask is 0 are skipped and output 0, other samples are not scaled by Mask
+	// Plug a biome weight or similar sparse mask so that the cost scales with the active region
+	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Mask, 1.f);
 	// Height difference of the lowest and highest point of the noise's largest octave
 	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Amplitude, 10000.f);
 	// Amount of space the noise will take to tile in the world, a divisor for position
@@ -87,12 +120,17 @@ public:
 	VOXEL_INPUT_PIN(int32, NumOctaves, 10);
 	// Used to randomize the output noise
 	VOXEL_INPUT_PIN(FVoxelSeed, Seed, nullptr);
+	// How octaves are combined. Ridged and HybridMultifractal feed each octave's signal back into the weight of the next one
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseAccumulation, Accumulation, EVoxelProceduralNoiseAccumulation::FBM, ShowInDetail);
 	// Default noise type
 	VOXEL_INPUT_PIN(EVoxelProceduralNoiseType2D, DefaultNoiseType, EVoxelProceduralNoiseType2D::Perlin, ShowInDetail);
 	// Noise type to use for generating a given octave
 	VOXEL_VARIADIC_INPUT_PIN(EVoxelProceduralNoiseType2D, OctaveType, EVoxelProceduralNoiseType2D::Default, 0, ShowInDetail);
 	// Multiplier for the amplitude of a given octave
 	VOXEL_VARIADIC_INPUT_PIN(FVoxelFloatBuffer, OctaveStrength, 1.f, 0, ShowInDetail);
+	// Use polynomial approximations of pow, exp, sin and cos in Voronoi, Crater, Gabor, Scratch, Wavelet and Erosion
+	// Faster, at the cost of a small error measured by the VCETNoiseAccuracy commandlet
+	VOXEL_INPUT_PIN(bool, FastMath, false, ShowInDetail);
 
 	// Result of all octaves being added together
 	VOXEL_OUTPUT_PIN(FVoxelFloatBuffer, Value);
@@ -100,6 +138,11 @@ public:
 	//~ Begin FVoxelNode Interface
 	virtual void Compute(FVoxelGraphQuery Query) const override;
 	//~ End FVoxelNode Interface
+
+	// Conservative bounds of Value for any position, given the range of the inputs over a region
+	// Tighter when Gain and all octave strengths are constant, as the octave weights are then known exactly
+	// Chunks entirely above or below these bounds don't need the noise to be evaluated
+	static FFloatInterval GetValueRange(const FVCETProceduralNoiseRangeInputs2D& Inputs);
 };
 
 // Generates multi-octave density noise from a collection of stylized procedural noises
@@ -112,6 +155,9 @@ struct VCET_API FVoxelNode_ProceduralNoise3D : public FVoxelNode
 public:
 	// Position at which to calculate output noise
 	VOXEL_INPUT_PIN(FVoxelVectorBuffer, Position, nullptr, PositionPin);
+	// Samples where Mask is 0 are skipped and output 0, other samples are not scaled by Mask
+	// Plug a biome weight or similar sparse mask so that the cost scales with the active region
+	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Mask, 1.f);
 	// Height difference of the lowest and highest point of the noise's largest octave
 	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Amplitude, 10000.f);
 	// Amount of space the noise will take to tile in the world, a divisor for position
@@ -130,12 +176,17 @@ public:
 	VOXEL_INPUT_PIN(int32, NumOctaves, 10);
 	// Used to randomize the output noise
 	VOXEL_INPUT_PIN(FVoxelSeed, Seed, nullptr);
+	// How octaves are combined. Ridged and HybridMultifractal feed each octave's signal back into the weight of the next one
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseAccumulation, Accumulation, EVoxelProceduralNoiseAccumulation::FBM, ShowInDetail);
 	// Default noise type
 	VOXEL_INPUT_PIN(EVoxelProceduralNoiseType3D, DefaultNoiseType, EVoxelProceduralNoiseType3D::Perlin, ShowInDetail);
 	// Noise type to use for generating a given octave
 	VOXEL_VARIADIC_INPUT_PIN(EVoxelProceduralNoiseType3D, OctaveType, EVoxelProceduralNoiseType3D::Default, 0, ShowInDetail);
 	// Multiplier for the amplitude of a given octave
 	VOXEL_VARIADIC_INPUT_PIN(FVoxelFloatBuffer, OctaveStrength, 1.f, 0, ShowInDetail);
+	// Use polynomial approximations of pow, exp, sin and cos in Voronoi, Crater, Gabor, Scratch, Wavelet and Erosion
+	// Faster, at the cost of a small error measured by the VCETNoiseAccuracy commandlet
+	VOXEL_INPUT_PIN(bool, FastMath, false, ShowInDetail);
 
 	// Result of all octaves being added together
 	VOXEL_OUTPUT_PIN(FVoxelFloatBuffer, Value);
@@ -143,4 +194,9 @@ public:
 	//~ Begin FVoxelNode Interface
 	virtual void Compute(FVoxelGraphQuery Query) const override;
 	//~ End FVoxelNode Interface
+
+	// Conservative bounds of Value for any position, given the range of the inputs over a region
+	// Tighter when Gain and all octave strengths are constant, as the octave weights are then known exactly
+	// Chunks entirely above or below these bounds don't need the noise to be evaluated
+	static FFloatInterval GetValueRange(const FVCETProceduralNoiseRangeInputs3D& Inputs);
 };
@@ -0,0 +1,133 @@
+// Copyright Zundle. MIT License.
+
+#pragma once
+
+#include "VoxelMinimal.h"
+#include "VoxelNode.h"
+#include "Buffer/VoxelFloatBuffers.h"
+#include "VCETProceduralNoiseNodes.h"
+#include "VCETProceduralNoiseTileNodes.generated.h"
+
+UENUM(BlueprintType, DisplayName = "Procedural Noise Tile Filter")
+enum class EVoxelProceduralNoiseTileFilter : uint8
+{
+	Linear UMETA(ToolTip = "Bilinear/trilinear interpolation: 4 or 8 texel reads per sample"),
+	Cubic UMETA(ToolTip = "Bicubic/tricubic Catmull-Rom interpolation: 16 or 64 texel reads per sample, smoother derivatives"),
+};
+
+// Samples a periodic tile baked from a procedural noise configuration
+// The tile is baked in parallel the first time a configuration is used, and shared by every graph using it
+// Tiles are kept in a least recently used cache of vcet.Noise.TileCacheMB
+// Trades exact evaluation for a filtered memory read: best suited to the expensive types (Erosion, Stone, Wool, Paper) used as detail octaves
+// Tiles are made periodic by blending the noise with copies of itself offset by one period, which slightly lowers contrast in the middle of the tile
+USTRUCT(Category = "Noise")
+struct VCET_API FVoxelNode_ProceduralNoiseTile2D : public FVoxelNode
+{
+	GENERATED_BODY()
+	GENERATED_VOXEL_NODE_BODY()
+
+public:
+	// Position at which to sample the tile
+	VOXEL_INPUT_PIN(FVoxelVector2DBuffer, Position, nullptr, PositionPin);
+	// Height difference of the lowest and highest point of the noise's largest octave
+	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Amplitude, 10000.f);
+	// Amount of space the noise will take to tile in the world, a divisor for position
+	VOXEL_INPUT_PIN(float, FeatureScale, 100000.f);
+	// A factor for how much smaller each octave's feature scale is compared to last octave's
+	VOXEL_INPUT_PIN(float, Lacunarity, 2.f);
+	// A factor for how much smaller each octave's amplitude is compared to last octave's
+	VOXEL_INPUT_PIN(float, Gain, 0.5f);
+	// Edge smoothness of the cell blending when using Voronoi noise
+	VOXEL_INPUT_PIN(float, VoronoiSmoothness, 1.f);
+	// Phase offset of the wavelets when using Wavelet noise
+	// Baked into the tile: every new value bakes a new tile, so keep it constant rather than animating it (use Procedural Noise for that)
+	VOXEL_INPUT_PIN(float, WaveletPhase, 0.f);
+	// Edge smoothness of the lines when using Scratch noise
+	VOXEL_INPUT_PIN(float, ScratchSmoothness, 0.05f);
+	// Amount of layers this noise should have
+	VOXEL_INPUT_PIN(int32, NumOctaves, 4);
+	// Used to randomize the output noise
+	VOXEL_INPUT_PIN(FVoxelSeed, Seed, nullptr);
+	// Size of the tile, in units of FeatureScale. The baked noise repeats every Period * FeatureScale
+	VOXEL_INPUT_PIN(int32, Period, 8);
+	// Number of texels along each side of the tile, rounded up to a power of two and clamped to [16, 2048]
+	// Octaves with features smaller than Period / Resolution are blurred out
+	VOXEL_INPUT_PIN(int32, Resolution, 512);
+	// How octaves are combined
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseAccumulation, Accumulation, EVoxelProceduralNoiseAccumulation::FBM, ShowInDetail);
+	// Default noise type
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseType2D, DefaultNoiseType, EVoxelProceduralNoiseType2D::Erosion, ShowInDetail);
+	// Noise type to use for generating a given octave
+	VOXEL_VARIADIC_INPUT_PIN(EVoxelProceduralNoiseType2D, OctaveType, EVoxelProceduralNoiseType2D::Default, 0, ShowInDetail);
+	// Multiplier for the amplitude of a given octave
+	VOXEL_VARIADIC_INPUT_PIN(float, OctaveStrength, 1.f, 0, ShowInDetail);
+	// Interpolation between texels
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseTileFilter, Filter, EVoxelProceduralNoiseTileFilter::Cubic, ShowInDetail);
+	// Use polynomial approximations of pow, exp, sin and cos when baking the tile
+	VOXEL_INPUT_PIN(bool, FastMath, false, ShowInDetail);
+
+	// Filtered value of the baked tile
+	VOXEL_OUTPUT_PIN(FVoxelFloatBuffer, Value);
+
+	//~ Begin FVoxelNode Interface
+	virtual void Compute(FVoxelGraphQuery Query) const override;
+	//~ End FVoxelNode Interface
+};
+
+// Samples a periodic volume baked from a procedural noise configuration
+// The volume is baked in parallel the first time a configuration is used, and shared by every graph using it
+// Trades exact evaluation for a filtered memory read: best suited to the expensive types (Erosion, Stone, Wool, Paper) used as detail octaves
+// Volumes are made periodic by blending the noise with copies of itself offset by one period, which slightly lowers contrast in the middle of the volume
+USTRUCT(Category = "Noise")
+struct VCET_API FVoxelNode_ProceduralNoiseTile3D : public FVoxelNode
+{
+	GENERATED_BODY()
+	GENERATED_VOXEL_NODE_BODY()
+
+public:
+	// Position at which to sample the volume
+	VOXEL_INPUT_PIN(FVoxelVectorBuffer, Position, nullptr, PositionPin);
+	// Height difference of the lowest and highest point of the noise's largest octave
+	VOXEL_INPUT_PIN(FVoxelFloatBuffer, Amplitude, 10000.f);
+	// Amount of space the noise will take to tile in the world, a divisor for position
+	VOXEL_INPUT_PIN(float, FeatureScale, 100000.f);
+	// A factor for how much smaller each octave's feature scale is compared to last octave's
+	VOXEL_INPUT_PIN(float, Lacunarity, 2.f);
+	// A factor for how much smaller each octave's amplitude is compared to last octave's
+	VOXEL_INPUT_PIN(float, Gain, 0.5f);
+	// Edge smoothness of the cell blending when using Voronoi noise
+	VOXEL_INPUT_PIN(float, VoronoiSmoothness, 1.f);
+	// Phase offset of the wavelets when using Wavelet noise
+	// Baked into the tile: every new value bakes a new tile, so keep it constant rather than animating it (use Procedural Noise for that)
+	VOXEL_INPUT_PIN(float, WaveletPhase, 0.f);
+	// Edge smoothness of the strands when using Scratch noise
+	VOXEL_INPUT_PIN(float, ScratchSmoothness, 0.05f);
+	// Amount of layers this noise should have
+	VOXEL_INPUT_PIN(int32, NumOctaves, 3);
+	// Used to randomize the output noise
+	VOXEL_INPUT_PIN(FVoxelSeed, Seed, nullptr);
+	// Size of the volume, in units of FeatureScale. The baked noise repeats every Period * FeatureScale
+	VOXEL_INPUT_PIN(int32, Period, 4);
+	// Number of texels along each side of the volume, rounded up to a power of two and clamped to [8, 128]
+	// Octaves with features smaller than Period / Resolution are blurred out
+	VOXEL_INPUT_PIN(int32, Resolution, 64);
+	// How octaves are combined
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseAccumulation, Accumulation, EVoxelProceduralNoiseAccumulation::FBM, ShowInDetail);
+	// Default noise type
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseType3D, DefaultNoiseType, EVoxelProceduralNoiseType3D::Erosion, ShowInDetail);
+	// Noise type to use for generating a given octave
+	VOXEL_VARIADIC_INPUT_PIN(EVoxelProceduralNoiseType3D, OctaveType, EVoxelProceduralNoiseType3D::Default, 0, ShowInDetail);
+	// Multiplier for the amplitude of a given octave
+	VOXEL_VARIADIC_INPUT_PIN(float, OctaveStrength, 1.f, 0, ShowInDetail);
+	// Interpolation between texels
+	VOXEL_INPUT_PIN(EVoxelProceduralNoiseTileFilter, Filter, EVoxelProceduralNoiseTileFilter::Linear, ShowInDetail);
+	// Use polynomial approximations of pow, exp, sin and cos when baking the volume
+	VOXEL_INPUT_PIN(bool, FastMath, false, ShowInDetail);
+
+	// Filtered value of the baked volume
+	VOXEL_OUTPUT_PIN(FVoxelFloatBuffer, Value);
+
+	//~ Begin FVoxelNode Interface
+	virtual void Compute(FVoxelGraphQuery Query) const override;
+	//~ End FVoxelNode Interface
+};
@@ -0,0 +1,44 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "VCETSettings.generated.h"
+
+/**
+ * Project settings of VCET (Project Settings > Plugins > VCET).
+ * The vcet.Bake.MemoryBudget.* console variables override them when set to 0 or more.
+ */
+UCLASS(Config = Game, DefaultConfig, meta = (DisplayName = "VCET"))
+class VCET_API UVCETSettings : public UDeveloperSettings
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * Budget of the memory owned by VCET, in MB: cached colors and render targets of the bakers, procedural noise tiles and bakes in flight.
+     * Over budget, the least recently used noise tiles then cached colors are evicted and new bakes wait for the bakes in flight to finish.
+     * 0 is unlimited
+     */
+    UPROPERTY(Config, EditAnywhere, Category = "Memory", meta = (ClampMin = "0", Units = "Megabytes"))
+    int32 MemoryBudgetMB = 0;
+
+    /**
+     * Write evicted cached colors to Saved/VCET/Cache and reload them when a static texture is created, instead of dropping them.
+     * Dropped caches need a rebake before their static texture can be created
+     */
+    UPROPERTY(Config, EditAnywhere, Category = "Memory")
+    bool bSpillEvictedCaches = false;
+
+    /**
+     * Voxel size of the query LOD 0 of the voxel graphs, in world units. Bakers with bAutoQueryLOD query the LOD whose voxels
+     * (QueryLODVoxelSize * 2^LOD) best match their texels, so coarse bakes don't evaluate detail they can't resolve
+     */
+    UPROPERTY(Config, EditAnywhere, Category = "Bake", meta = (ClampMin = "0", Units = "Centimeters"))
+    float QueryLODVoxelSize = 100.f;
+
+    //~ Begin UDeveloperSettings Interface
+    virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
+    //~ End UDeveloperSettings Interface
+};
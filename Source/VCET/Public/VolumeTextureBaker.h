@@ -3,14 +3,17 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Components/ActorComponent.h"
+#include "VCETBakerComponent.h"
 #include "Engine/VolumeTexture.h"
 #include "Engine/TextureRenderTargetVolume.h"
 #include "VoxelMinimal.h"
 #include "VoxelStackLayer.h"
+#include "VCETChannelPacking.h"
+#include "VCETColumnReduction.h"
 #include "VolumeTextureBaker.generated.h"
 
 class UVoxelMetadata;
+class UTextureRenderTarget2D;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnVolumeTextureBaked);
 
@@ -37,7 +40,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnVolumeTextureBaked);
  * 5. Use the output VolumeTexture in your materials (Material Parameter Collection recommended)
  */
 UCLASS(ClassGroup=(VCET), meta=(BlueprintSpawnableComponent), DisplayName="VCET Volume Texture Baker")
-class VCET_API UVolumeTextureBaker : public UActorComponent
+class VCET_API UVolumeTextureBaker : public UVCETBakerComponent
 {
     GENERATED_BODY()
 
@@ -50,17 +53,36 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
     FVoxelStackVolumeLayer VolumeLayer;
     
+    /** 
+     * Query the LOD matching the texel size (see Project Settings > Plugins > VCET > Query LOD Voxel Size),
+     * so coarse bakes don't evaluate graph detail they can't resolve. Disable to use QueryLOD
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
+    bool bAutoQueryLOD = true;
+    
+    /** LOD of the queries when bAutoQueryLOD is disabled. 0 is full detail */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel", meta = (ClampMin = "0", ClampMax = "24", EditCondition = "!bAutoQueryLOD"))
+    int32 QueryLOD = 0;
+    
     
     /** 
      * Metadata to sample (optional).
      * - Float Metadata ? grayscale density (written to RGB channels)
      * - LinearColor Metadata ? full RGBA color data
+     * - Normal Metadata ? RGB channels, remapped to 0-1
      * - None ? samples distance field directly (grayscale)
      * 
      * Automatically detects metadata type and formats data appropriately.
      */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
     TObjectPtr<UVoxelMetadata> Metadata;
+    
+    /** 
+     * Packs up to four sources into the RGBA channels instead of sampling Metadata, all in one query,
+     * e.g. density, temperature, wetness and distance. Each channel has its own remap; the Processing options are ignored
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel")
+    FVCETChannelPacking Channels;
 
     // === Volume Region ===
     
@@ -69,8 +91,21 @@ public:
     FVector VolumeCenter = FVector::ZeroVector;
     
     /** Size of the sampling region - this will be mapped to the 3D texture cube */
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Volume Region")
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Volume Region", meta = (EditCondition = "!bUseSphericalRegion"))
     FVector VolumeSize = FVector(50000.0f, 50000.0f, 50000.0f);
+    
+    /** 
+     * Sample a spherical shell around VolumeCenter instead of a box.
+     * The texture is unwrapped as longitude (X), latitude (Y) and radius from InnerRadius to OuterRadius (Z)
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Volume Region")
+    bool bUseSphericalRegion = false;
+    
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Volume Region", meta = (EditCondition = "bUseSphericalRegion"))
+    float InnerRadius = 637100.0f;
+    
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Volume Region", meta = (EditCondition = "bUseSphericalRegion"))
+    float OuterRadius = 657100.0f;
 
     // === Volume Texture Settings ===
     
@@ -105,6 +140,29 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Processing", meta = (ClampMin = "0.01", ClampMax = "100.0"))
     float ResultMultiplier = 1.0f;
 
+    // === Column Reductions ===
+    
+    /** 
+     * Also reduce every vertical column of the volume (along Z, or along the radius in spherical mode) into 2D maps:
+     * coverage, integrated density, max density, cloud base and cloud top (see FVCETColumnReduction).
+     * Computed from the baked samples on the bake's worker, so one bake replaces a stack of planar bakes.
+     * Results are in ColumnReductions, and with bWriteColumnReductionTextures in ColumnDensityTexture and ColumnHeightTexture
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column Reductions")
+    bool bComputeColumnReductions = false;
+    
+    /** Channel of the baked volume holding the density. Any of RGB for distance fields and float metadata */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column Reductions", meta = (EditCondition = "bComputeColumnReductions"))
+    EVCETChannelComponent ColumnDensityChannel = EVCETChannelComponent::R;
+    
+    /** Processed density above which a sample counts towards the coverage, cloud base and cloud top */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column Reductions", meta = (EditCondition = "bComputeColumnReductions"))
+    float ColumnDensityThreshold = 0.01f;
+    
+    /** Upload the reductions to two RGBA32F render targets of VolumeResolution x VolumeResolution texels */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Column Reductions", meta = (EditCondition = "bComputeColumnReductions"))
+    bool bWriteColumnReductionTextures = true;
+
     // === Lifecycle ===
     
     /** Bake on BeginPlay */
@@ -145,6 +203,18 @@ public:
     UPROPERTY(BlueprintReadOnly, Category = "Output")
     TObjectPtr<UVolumeTexture> StaticVolumeTexture;
     
+    /** Column reductions, R: coverage, G: integrated density, B: max density */
+    UPROPERTY(BlueprintReadOnly, Category = "Output")
+    TObjectPtr<UTextureRenderTarget2D> ColumnDensityTexture;
+    
+    /** Column reductions, R: cloud base, G: cloud top, in world units */
+    UPROPERTY(BlueprintReadOnly, Category = "Output")
+    TObjectPtr<UTextureRenderTarget2D> ColumnHeightTexture;
+    
+    /** Column reductions of the last bake, VolumeResolution^2 columns, X fastest (if bComputeColumnReductions is enabled) */
+    UPROPERTY(BlueprintReadOnly, Transient, Category = "Output")
+    TArray<FVCETColumnReduction> ColumnReductions;
+    
     /** Called when baking completes */
     UPROPERTY(BlueprintAssignable, Category = "Events")
     FOnVolumeTextureBaked OnBakeComplete;
@@ -163,6 +233,10 @@ public:
     UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Volume Texture")
     UVolumeTexture* GetStaticVolumeTexture() const { return StaticVolumeTexture; }
     
+    /** Get the reduction of column (X, Y) of the last bake. Zero if out of range or bComputeColumnReductions is disabled */
+    UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Volume Texture")
+    FVCETColumnReduction GetColumnReduction(int32 X, int32 Y) const;
+    
     /** Check if currently baking */
     UFUNCTION(BlueprintCallable, BlueprintPure, Category = "VCET|Volume Texture")
     bool IsBaking() const { return bIsBaking; }
@@ -175,18 +249,26 @@ public:
     UFUNCTION(BlueprintCallable, Category = "VCET|Volume Texture", meta = (WorldContext = "WorldContextObject"))
     static void RequestGlobalRebake(UObject* WorldContextObject);
 
+    //~ Begin UVCETBakerComponent Interface
+    virtual void StartBake() override { ForceRebake(); }
+    virtual bool IsBakeInProgress() const override { return IsBaking(); }
+    virtual TArray<UTexture*> SaveBakedTextures(bool bReplaceExisting) override;
+    //~ End UVCETBakerComponent Interface
+
 protected:
     virtual void BeginPlay() override;
 
 private:
     bool bIsBaking = false;
     
-    // Cached color data from last bake (used for creating static textures)
-    TArray<FLinearColor> CachedColorData;
+    /** Size of the column reductions, ColumnReductions being VolumeResolution^2 at the time of the bake */
+    int32 ColumnReductionSize = 0;
     
     void CreateVolumeRT();
+    void CreateColumnReductionRT(TObjectPtr<UTextureRenderTarget2D>& Out);
     void BakeVolume();
-    void WriteToVolumeRT(const TArray<FLinearColor>& ColorData);
+    void WriteToVolumeRT(const TArray<FLinearColor>& ColorData, FVCETBakeTelemetry* Telemetry = nullptr);
+    void WriteColumnReductions(FVCETBakeTelemetry* Telemetry);
     void CreateStaticAssetIfNeeded();
-    FString GetUniqueAssetName(const FString& PackagePath, const FString& BaseName);
+    UVolumeTexture* CreateStaticTextureImpl(bool bReplaceExisting);
 };
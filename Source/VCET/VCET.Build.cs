@@ -17,7 +17,8 @@ public class VCET : ModuleRules
             "VoxelGraph",
             "Voxel",
             "RenderCore",
-            "RHI"
+            "RHI",
+            "DeveloperSettings"
         });
 
         PrivateDependencyModuleNames.AddRange(new string[]